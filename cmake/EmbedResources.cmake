@@ -0,0 +1,41 @@
+# Writes the default resources as C++ arrays for src/EmbeddedResources.cpp.
+# Run in script mode:
+#   cmake -DRESOURCE_DIR=<resources dir> -DOUTPUT=<file> -P EmbedResources.cmake
+#
+# Everything the game loads through Art is embedded: sheets, sound
+# effects, music, the zone odds and the golden level hashes. Soundfonts
+# are left out (FluidSynth reads them by path).
+
+file(GLOB_RECURSE files RELATIVE "${RESOURCE_DIR}"
+    "${RESOURCE_DIR}/*.png"
+    "${RESOURCE_DIR}/*.gif"
+    "${RESOURCE_DIR}/snd/*.wav"
+    "${RESOURCE_DIR}/mus/*.mid"
+    "${RESOURCE_DIR}/zones.cfg"
+    "${RESOURCE_DIR}/level-hashes.txt"
+)
+# Sorted, so EmbeddedResources::find can binary search the table
+list(SORT files)
+
+set(arrays "")
+set(table "")
+set(index 0)
+foreach(name IN LISTS files)
+    file(READ "${RESOURCE_DIR}/${name}" hex HEX)
+    string(LENGTH "${hex}" digits)
+    math(EXPR size "${digits} / 2")
+    # 0x.. per byte, 32 bytes per line; a trailing 0 keeps empty files
+    # valid and text files NUL-terminated
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," hex "${hex}")
+    string(REGEX REPLACE "((0x..,){32})" "\\1\n" hex "${hex}")
+    string(APPEND arrays "static const uint8_t RESOURCE_${index}[] = {\n${hex}0};\n")
+    string(APPEND table "    {\"${name}\", RESOURCE_${index}, ${size}},\n")
+    math(EXPR index "${index} + 1")
+endforeach()
+
+file(WRITE "${OUTPUT}"
+    "// Generated by cmake/EmbedResources.cmake from ${RESOURCE_DIR}; do not edit\n"
+    "${arrays}\n"
+    "static const EmbeddedResource EMBEDDED_RESOURCES[] = {\n${table}};\n"
+    "static const size_t EMBEDDED_RESOURCE_COUNT = ${index};\n"
+)
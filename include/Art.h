@@ -14,6 +14,8 @@
 #include "Common.h"
 #include <array>
 
+struct CookedImage;
+
 // Sound sample indices
 enum SampleIndex {
     SAMPLE_BREAK_BLOCK = 0,
@@ -44,6 +46,17 @@ enum MusicIndex {
     MUSIC_COUNT = 5
 };
 
+// Images only some scenes draw. They are loaded when a scene first
+// holds them (see AssetHandle) and freed when no scene does.
+enum SceneAsset {
+    ASSET_WORLD_MAP = 0,
+    ASSET_END_SCENE = 1,
+    ASSET_GAME_OVER = 2,
+    ASSET_LOGO = 3,
+    ASSET_TITLE_SCREEN = 4,
+    SCENE_ASSET_COUNT = 5
+};
+
 class Art {
 public:
     static bool init(SDL_Renderer* renderer, const std::string& resourcePath);
@@ -54,6 +67,14 @@ public:
     
     // Resolve a resource path - checks user directory first, then system
     static std::string resolveResource(const std::string& relativePath);
+    // Path of the user's own copy of a resource, or "" if there is none
+    static std::string findUserOverride(const std::string& relativePath);
+    // Open a resource for SDL: the user's copy, else the resource archive
+    // entry, else the file in the resource directory. nullptr if none
+    // exists. Pass freesrc = 1 to the loader (IMG_Load_RW, Mix_Load*_RW).
+    static SDL_RWops* openResource(const std::string& relativePath);
+    // Read a whole resource from wherever openResource() finds it
+    static bool readResource(const std::string& relativePath, std::string& out);
     
     // Sprite sheets (2D arrays of textures)
     static std::vector<std::vector<SDL_Texture*>> mario;
@@ -65,20 +86,23 @@ public:
     static std::vector<std::vector<SDL_Texture*>> particles;
     static std::vector<std::vector<SDL_Texture*>> font;
     static std::vector<std::vector<SDL_Texture*>> bg;
+    // Scene assets: empty (or nullptr) unless a scene holds them
     static std::vector<std::vector<SDL_Texture*>> map;
     static std::vector<std::vector<SDL_Texture*>> endScene;
     static std::vector<std::vector<SDL_Texture*>> gameOver;
-    
-    // Single images
     static SDL_Texture* logo;
     static SDL_Texture* titleScreen;
     
+    // Reference-counted loading of scene assets; prefer AssetHandle
+    static void acquire(SceneAsset asset);
+    static void release(SceneAsset asset);
+    
     // Sound effects
     static std::array<Mix_Chunk*, SAMPLE_COUNT> samples;
     
-    // Music
+    // Music (loaded and played by the audio thread)
     static std::array<Mix_Music*, MUSIC_COUNT> music;
-    static int currentMusic;
+    static int currentMusic;  // Track last started, -1 after stopMusic()
     
     // Renderer reference
     static SDL_Renderer* renderer;
@@ -86,25 +110,71 @@ public:
     static std::string userDataDir;
     
     // Helper functions
+    // Queue a sound effect; flushSounds() starts the tick's sounds
     static void playSound(int sampleIndex);
+    // Start the sounds queued this tick, each once, most important first,
+    // taking over voices playing less important sounds if all are busy.
+    // Call once per tick.
+    static void flushSounds();
+    // Music calls queue a command for the audio thread and return at once
     static void startMusic(int musicIndex, bool forceRestart = false);
+    static void preloadMusic(int musicIndex);  // Load a track to start it later without a wait
     static void stopMusic();
+    static void pauseMusic(bool paused);
     static void cycleMidiSynth();  // Cycle through MIDI synth options
     static void adjustMusicVolume(int delta);  // Adjust music volume (+/- delta)
     static int getMusicVolume();  // Get current music volume (0-128)
     static void adjustSfxVolume(int delta);  // Adjust SFX volume (+/- delta)
     static int getSfxVolume();  // Get current SFX volume (0-128)
     static void initVolumeFromConfig();  // Load volume settings from config
+    // Audio starts on a thread of init()'s; sound effects asked for
+    // before it is up are held back. Call once per frame: the first call
+    // after the device is open plays them.
+    static void updateAudio();
     
     // Draw text
     static void drawString(const std::string& text, int x, int y, int color);
     
 private:
-    static SDL_Surface* loadImage(const std::string& path);
-    static std::vector<std::vector<SDL_Texture*>> cutImage(const std::string& path, int xSize, int ySize);
-    static SDL_Texture* loadTexture(const std::string& path);
+    // Decode every startup image on a pool of workers, then create the
+    // textures on this (the render) thread. Timings go to the debug log.
+    static void loadAssets();
+    static std::vector<std::vector<SDL_Texture*>> cutImage(const CookedImage& sheet, int xSize, int ySize);
+    static SDL_Texture* createTexture(const CookedImage& image, int x, int y, int w, int h);
+    static void freeSheet(std::vector<std::vector<SDL_Texture*>>& sheet);
     
 public:
     // File existence check (public for use by helper functions)
     static bool fileExists(const std::string& path);
 };
+
+/**
+ * Keeps a scene asset loaded for as long as the handle holds it.
+ */
+class AssetHandle {
+public:
+    AssetHandle() = default;
+    explicit AssetHandle(SceneAsset asset) : asset(asset) { Art::acquire(asset); }
+    ~AssetHandle() { reset(); }
+    
+    AssetHandle(const AssetHandle&) = delete;
+    AssetHandle& operator=(const AssetHandle&) = delete;
+    AssetHandle(AssetHandle&& other) : asset(other.asset) { other.asset = -1; }
+    AssetHandle& operator=(AssetHandle&& other) {
+        if (this != &other) {
+            reset();
+            asset = other.asset;
+            other.asset = -1;
+        }
+        return *this;
+    }
+    
+    bool held() const { return asset >= 0; }
+    void reset() {
+        if (asset >= 0) Art::release((SceneAsset)asset);
+        asset = -1;
+    }
+
+private:
+    int asset = -1;
+};
@@ -0,0 +1,31 @@
+/**
+ * @file Autotiler.h
+ * @brief Edge and corner tiles for level ground.
+ * @ingroup level
+ *
+ * Level generators lay ground down as one plain tile. Autotiler then
+ * picks the edge, corner or fill variant of every ground tile from
+ * which of its four corners lie inside solid ground, using the
+ * sheet's ground block for the level type (overground, castle or
+ * underground).
+ *
+ * Each column is packed into a bitmask of ground rows, so the corner
+ * masks of a whole column come from a few shifts and ANDs and each
+ * ground tile is one 16-entry table lookup. Only the columns around
+ * an edited range are redone, which lets generators tile zone by zone
+ * and lets runtime ground edits update their neighbours.
+ */
+#pragma once
+#include "Common.h"
+
+class Level;
+
+class Autotiler {
+public:
+    // Ground as placed by a generator, or any tile Autotiler produces
+    static bool isGround(uint8_t tile);
+    
+    // Re-tile after the ground in columns [x0, x1) changed. Tiles in the
+    // neighbouring columns are updated too; other tiles are untouched.
+    static void apply(Level* level, int type, int x0, int x1);
+};
@@ -16,16 +16,24 @@ public:
     int xCam = 0;
     int yCam = 0;
     
+    /// Width in tiles of generated background levels (like Java). The
+    /// background repeats after this many tiles, so levels of any width
+    /// scroll over it.
+    static constexpr int BG_WIDTH = 2048;
+    
     BgRenderer(int width, int height, int levelType, int distance, bool distant);
+    /// Use an already generated background level (takes ownership)
+    BgRenderer(int width, int height, int levelType, int distance, Level* bgLevel);
     ~BgRenderer();
     void setCam(int xCam, int yCam);
     void render(SDL_Renderer* renderer, int tick);
+    
+    /// Pure CPU work with no SDL calls, so it may run on any thread
+    static Level* generateBgLevel(int w, int h, bool distant, int type);
 
 private:
     int width, height;
     int levelType;
     int distance;
     Level* bgLevel = nullptr;
-    
-    Level* generateBgLevel(int w, int h, bool distant, int type);
 };
@@ -23,6 +23,10 @@ public:
     bool shellCollideCheck(Shell* shell) override;
     bool fireballCollideCheck(Fireball* fireball) override;
 
+    SpriteKind getKind() const override { return SpriteKind::BULLET_BILL; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     LevelScene* world;
 };
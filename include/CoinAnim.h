@@ -14,6 +14,10 @@ public:
     CoinAnim(int xTile, int yTile);
     void move() override;
 
+    SpriteKind getKind() const override { return SpriteKind::COIN_ANIM; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     int life = 10;
 };
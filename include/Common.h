@@ -81,7 +81,8 @@ public:
     }
     
     int next(int bits) {
-        seed = (seed * 0x5DEECE66DLL + 0xBLL) & ((1LL << 48) - 1);
+        // Unsigned so the multiply wraps instead of overflowing
+        seed = (int64_t)(((uint64_t)seed * 0x5DEECE66DULL + 0xBULL) & ((1ULL << 48) - 1));
         return (int)(seed >> (48 - bits));
     }
     
@@ -97,16 +98,23 @@ public:
             return (int)((bound * (int64_t)next(31)) >> 31);
         }
         
+        // Java rejects a draw when this sum overflows int; the sum is
+        // done unsigned so the wrap is defined
         int bits, val;
         do {
             bits = next(31);
             val = bits % bound;
-        } while (bits - val + (bound - 1) < 0);
+        } while ((int32_t)((uint32_t)bits - (uint32_t)val + (uint32_t)(bound - 1)) < 0);
         return val;
     }
     
+    // The two halves are drawn in separate statements: operand order
+    // within one expression is unspecified, and Java draws the high half
+    // first
     int64_t nextLong() {
-        return ((int64_t)next(32) << 32) + next(32);
+        int64_t high = next(32);
+        int64_t low = next(32);
+        return (int64_t)(((uint64_t)high << 32) + (uint64_t)low);
     }
     
     float nextFloat() {
@@ -114,13 +122,22 @@ public:
     }
     
     double nextDouble() {
-        return (((int64_t)next(26) << 27) + next(27)) / (double)(1LL << 53);
+        int64_t high = next(26);
+        int64_t low = next(27);
+        return ((high << 27) + low) / (double)(1LL << 53);
     }
     
     bool nextBoolean() {
         return next(1) != 0;
     }
     
+    // Raw generator state, for savestates (seed is already scrambled)
+    int64_t getState() const { return seed; }
+    void setState(int64_t state) {
+        seed = state & ((1LL << 48) - 1);
+        haveNextGaussian = false;
+    }
+    
     double nextGaussian() {
         // Box-Muller transform for Gaussian distribution
         if (haveNextGaussian) {
@@ -0,0 +1,32 @@
+/**
+ * @file EmbeddedResources.h
+ * @brief Default resources compiled into the executable.
+ * @ingroup core
+ *
+ * Built with INFINITE_TUX_EMBED_RESOURCES, the executable carries the
+ * stock images, sounds, music, zones.cfg and level-hashes.txt (see
+ * cmake/EmbedResources.cmake) and needs no resources/ directory:
+ * findResourcePath does not look for one and Art reads the defaults
+ * from memory. User overrides still take priority. Without the option
+ * the table is empty.
+ *
+ * Tile behaviors are not embedded; the defaults are compiled in anyway
+ * (TileTables.h).
+ */
+#pragma once
+#include "Common.h"
+#include <string_view>
+
+struct EmbeddedResource {
+    const char* name;      ///< Relative path, such as "snd/coin.wav"
+    const uint8_t* data;   ///< Followed by a 0 byte
+    size_t size;
+};
+
+class EmbeddedResources {
+public:
+    // True if this build carries the default resources
+    static bool available();
+    // Binary search of the table; nullptr if there is no such resource
+    static const EmbeddedResource* find(std::string_view name);
+};
@@ -37,6 +37,10 @@ public:
     bool fireballCollideCheck(Fireball* fireball) override;
     void bumpCheck(int xTile, int yTile) override;
 
+    SpriteKind getKind() const override { return SpriteKind::ENEMY; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 protected:
     static constexpr float GROUND_INERTIA = 0.89f;
     static constexpr float AIR_INERTIA = 0.89f;
@@ -17,6 +17,10 @@ public:
     void move() override;
     void collideCheck() override;
 
+    SpriteKind getKind() const override { return SpriteKind::FIRE_FLOWER; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     LevelScene* world;
     int life = 0;
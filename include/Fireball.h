@@ -21,6 +21,10 @@ public:
     void move() override;
     void die();
 
+    SpriteKind getKind() const override { return SpriteKind::FIREBALL; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     LevelScene* world;
     int width = 4;
@@ -26,7 +26,11 @@ public:
     void move() override;
     bool fireballCollideCheck(Fireball* fireball) override;
     bool shellCollideCheck(Shell* shell) override;
-    
+
+    SpriteKind getKind() const override { return SpriteKind::FLOWER_ENEMY; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     int tick = 0;
     int yStart;      ///< Y position of pipe top - plant is protected when y >= yStart - 8
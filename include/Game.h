@@ -11,6 +11,9 @@
  */
 #pragma once
 #include "Common.h"
+#include "Rewind.h"
+#include "LevelPregenerator.h"
+#include "LevelPack.h"
 #include <memory>
 
 class Scene;
@@ -25,8 +28,10 @@ enum class PendingScene {
     WIN,
     LOSE,
     LEVEL,        // Start a new level (uses pendingLevel* fields)
+    ENDLESS,      // Start an endless level (uses pendingLevel* fields)
     LEVEL_FAILED, // Return to map after failing level
-    LEVEL_WON     // Return to map after winning level
+    LEVEL_WON,    // Return to map after winning level
+    LOAD_STATE    // Resume a level from a savestate (uses pendingStatePath)
 };
 
 class Game {
@@ -38,8 +43,44 @@ public:
     void run();
     void cleanup();
     
+    // --validate: generate levels for `count` seeds from `firstSeed` in
+    // every level type and report the ones whose exit is unreachable.
+    // Runs without SDL; returns the process exit code.
+    static int validateLevels(int64_t firstSeed, int64_t count, int difficulty);
+    // --stats: write LevelStats for the same seed range as CSV to stdout
+    static int writeLevelStats(int64_t firstSeed, int64_t count, int difficulty);
+    // --find-seeds: scan seeds for levels of `type` matching every condition
+    // (e.g. "cannons>6") and write their statistics as CSV to stdout
+    static int findSeeds(int64_t firstSeed, int64_t count, int difficulty, int type,
+                         const std::vector<std::string>& conditions);
+    // --level-hashes: print the golden level hash corpus to stdout
+    static int writeLevelHashes();
+    // --check-hashes: compare generated levels with a corpus file
+    // (resources/level-hashes.txt by default)
+    static int checkLevelHashes(const std::string& path);
+    // --write-pack: generate `count` seeds from `firstSeed` in every level
+    // type, `width` tiles wide (0 = LevelScene::LEVEL_WIDTH), into a level pack
+    static int writeLevelPack(const std::string& path, int64_t firstSeed, int count, int difficulty, int width);
+    // --check-pack: load every level in a pack and compare it with a
+    // freshly generated one
+    static int checkLevelPack(const std::string& path);
+    // --write-archive: pack the images, sounds and music under
+    // `directory` (the resources directory if empty) into a resource archive
+    static int writeResourceArchive(const std::string& path, const std::string& directory);
+    // --check-archive: list a resource archive and verify every file
+    static int checkResourceArchive(const std::string& path);
+    // --bench-ticks: time LevelScene ticks and rewind recording on flat
+    // levels from 320 to 100,000 columns and write the results as CSV
+    static int benchmarkTicks(int ticks);
+    
+    // Width of generated levels, in tiles (--level-width). Call before init().
+    void setLevelWidth(int width) { levelWidth = width; }
+    // Play levels from a pack where it has them (--level-pack)
+    bool useLevelPack(const std::string& path);
+    
     // Scene management (these now queue scene changes for end of frame)
-    void startLevel(long seed, int difficulty, int type);
+    void startLevel(int64_t seed, int difficulty, int type);
+    void startEndless(int64_t seed, int difficulty, int type);
     void levelFailed();
     void levelWon();
     void win();
@@ -48,6 +89,13 @@ public:
     void toOptions();
     void startGame();
     
+    // Build these levels in the background, most likely first
+    void pregenerateLevels(const std::vector<LevelKey>& keys);
+    
+    // Savestates (F2 quicksave, F3 quickload, --load-state FILE)
+    bool saveState(const std::string& path);
+    void loadState(const std::string& path);
+    
     // Display management
     void setFullscreen(bool fullscreen);
     void toggleFullscreen();
@@ -70,15 +118,27 @@ private:
     
     Scene* scene = nullptr;
     MapScene* mapScene = nullptr;
+    LevelPregenerator* pregenerator = nullptr;
+    int levelWidth = 0;  ///< 0 = LevelScene::LEVEL_WIDTH
+    std::unique_ptr<LevelPack> levelPack;
     
     // Pending scene change (processed at end of frame to avoid use-after-free)
     PendingScene pendingScene = PendingScene::NONE;
-    long pendingLevelSeed = 0;
+    int64_t pendingLevelSeed = 0;
     int pendingLevelDifficulty = 0;
     int pendingLevelType = 0;
+    std::string pendingStatePath;
+    
+    bool mapSceneStarted = false;  ///< mapScene->init() has run at least once
+    
+    // Rewind: the last few seconds of the current level, replayed
+    // backwards one tick per frame while F4 is held
+    Rewind rewind;
+    bool rewinding = false;
     
     void handleEvents();
     void updateGameInput();
+    void tickScene();
     void adjustFPS();
     void updateViewport();
     void processPendingSceneChange();
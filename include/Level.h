@@ -8,8 +8,12 @@
  */
 #pragma once
 #include "Common.h"
+#include "SpriteTemplate.h"
+#include <deque>
 
-class SpriteTemplate;
+class StateWriter;
+class StateReader;
+struct TileTables;
 
 class Level {
 public:
@@ -23,34 +27,127 @@ public:
     static constexpr int BIT_PICKUPABLE = 1 << 6;
     static constexpr int BIT_ANIMATED = 1 << 7;
     
-    // Tile behaviors array
+    // Tile behaviors and the tables derived from them (see TileTables.h).
+    // Both hold the built-in defaults unless loadBehaviors() replaced them.
     static std::array<uint8_t, 256> TILE_BEHAVIORS;
+    static TileTables TILE_TABLES;
     
     int width;
     int height;
     
-    std::vector<std::vector<uint8_t>> map;
-    std::vector<std::vector<uint8_t>> data;
-    std::vector<std::vector<SpriteTemplate*>> spriteTemplates;
+    // Column-major tile storage: index = x * height + y, so each
+    // column is contiguous and whole arrays can be copied in bulk.
+    std::vector<uint8_t> map;
+    std::vector<uint8_t> data;
+    std::vector<SpriteTemplate*> spriteTemplates;  ///< Points into templateStorage or templateSlots
     
     int xExit;
     int yExit;
     
+    // Columns [firstColumn, endColumn) hold the playable level. Fixed
+    // levels span their whole width; endless levels (see LevelStream)
+    // move the range along as they are built and retired.
+    int firstColumn = 0;
+    int endColumn;
+    
+    // Store column x at x mod width instead of clamping it, so a fixed
+    // ring of columns is reused as an endless level scrolls
+    bool wrapColumns = false;
+    
+    /// One change to the level, as recorded for rewind
+    struct TileEdit {
+        enum Kind : uint8_t {
+            TILE,           ///< map
+            DATA,           ///< Bump data
+            TEMPLATE_DEAD,  ///< SpriteTemplate::isDead
+            TEMPLATE_SEEN   ///< SpriteTemplate::lastVisibleTick
+        };
+        uint32_t index;  ///< x * height + y
+        int32_t value;
+        int32_t old;     ///< Value before the change, for undoing it
+        Kind kind;
+    };
+    
+    /// When set, every change to map, data or template state is appended
+    /// here (see Rewind)
+    std::vector<TileEdit>* editLog = nullptr;
+    
     Level(int width, int height);
-    ~Level();
+    Level(const Level&) = delete;
+    Level& operator=(const Level&) = delete;
+    
+    // Clear to an empty level of the same size, keeping allocations
+    void reset();
+    
+    // Deep copy, including fresh sprite templates (spawn state reset)
+    Level* copy() const;
+    // Approximate heap footprint in bytes
+    size_t memoryUsage() const;
+    // FNV-1a hash of size, tiles, bump data, sprite templates and exit.
+    // Depends only on content, so it matches across platforms.
+    uint64_t contentHash() const;
     
+    // Replace the built-in behaviors with a 256-byte tiles.dat (a user
+    // override). Not thread-safe: call before building levels.
     static bool loadBehaviors(const std::string& path);
     static bool saveBehaviors(const std::string& path);
     
+    // Count down bump data. Only cells with data set are visited, so
+    // the cost does not grow with the level size.
     void tick();
     
     uint8_t getBlockCapped(int x, int y) const;
     uint8_t getBlock(int x, int y) const;
     void setBlock(int x, int y, uint8_t b);
     void setBlockData(int x, int y, uint8_t b);
+    uint8_t getBlockData(int x, int y) const;
+    // Put back the value an edit replaced
+    void revertEdit(const TileEdit& edit);
     
     bool isBlocking(int x, int y, float xa, float ya) const;
     
+    // Physical column for logical column x (wrapped or clamped)
+    int columnIndex(int x) const {
+        if (wrapColumns) {
+            x %= width;
+            return x < 0 ? x + width : x;
+        }
+        return x < 0 ? 0 : (x >= width ? width - 1 : x);
+    }
+    // Empty columns [x0, x1): tiles, bump data and templates
+    void clearColumns(int x0, int x1);
+    
     SpriteTemplate* getSpriteTemplate(int x, int y) const;
-    void setSpriteTemplate(int x, int y, SpriteTemplate* spriteTemplate);
+    // Create a template owned by the level; nullptr if (x, y) is outside it
+    SpriteTemplate* addSpriteTemplate(int x, int y, int type, bool winged);
+    // Template state changes made during play go through these so that
+    // they reach editLog
+    void markTemplateDead(SpriteTemplate* st);
+    void markTemplateSeen(SpriteTemplate* st, int tick);
+    // Rebuild the list of counting-down cells after writing `data` directly
+    void findAnimatedCells();
+    
+    // Savestate support: tiles, bump data and exit (templates are
+    // written by LevelScene, which knows their live sprites)
+    void writeState(StateWriter& out) const;
+    static Level* readState(StateReader& in);
+
+private:
+    // Templates live in one container instead of one allocation each;
+    // deque keeps their addresses stable as more are added
+    std::deque<SpriteTemplate> templateStorage;
+    // With wrapColumns, one template slot per cell instead, so retired
+    // columns give their slots to the columns that replace them
+    std::vector<SpriteTemplate> templateSlots;
+    
+    // Cells whose bump data is counting down
+    std::vector<uint32_t> animatedCells;
+    
+    void logEdit(uint32_t index, int32_t value, int32_t old, TileEdit::Kind kind) {
+        if (editLog) editLog->push_back({index, value, old, kind});
+    }
+    
+    bool inside(int x, int y) const {
+        return y >= 0 && y < height && (wrapColumns || (x >= 0 && x < width));
+    }
 };
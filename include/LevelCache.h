@@ -0,0 +1,41 @@
+/**
+ * @file LevelCache.h
+ * @brief LRU cache of freshly generated levels.
+ * @ingroup level
+ *
+ * Generation is deterministic, so retrying a level after death,
+ * replays and batch runs all rebuild identical levels. LevelCache keeps
+ * pristine copies keyed by everything that affects generation and
+ * hands out deep copies, which cost two tile-array memcpys plus the
+ * sprite templates instead of a full LevelGenerator run.
+ *
+ * The cache is bounded by an approximate byte budget (least recently
+ * used levels are evicted first) and is safe to use from several
+ * threads.
+ *
+ * With a level pack in use (see LevelPack), levels it holds are loaded
+ * from the pack instead of generated.
+ */
+#pragma once
+#include "Common.h"
+
+class Level;
+class LevelPack;
+
+class LevelCache {
+public:
+    // Return a level the caller owns: a copy of the cached one, or a
+    // newly generated level (which is then cached)
+    static Level* acquire(int width, int height, int64_t seed, int difficulty, int type);
+    
+    // Byte budget for cached levels; 0 disables caching
+    static void setBudget(size_t bytes);
+    static void clear();
+    
+    // Serve levels of the right size from `pack` when it holds them
+    // (nullptr to stop). The pack must stay open while it is in use.
+    static void usePack(const LevelPack* pack);
+    
+    static size_t hits();
+    static size_t misses();
+};
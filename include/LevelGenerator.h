@@ -5,47 +5,123 @@
  * 
  * LevelGenerator creates playable levels from a seed.
  * Same seed always produces same level.
+ *
+ * A level is a run of zones (straight, hills, tubes, jumps, cannons)
+ * picked at random. The odds of each zone type come from zones.cfg and
+ * scale with difficulty; see LevelGenerator::loadZoneConfig.
  */
 #pragma once
 #include "Common.h"
+#include <functional>
 
 class Level;
 
+/// Knobs for generateInto when only part of the result is needed
+struct GenerateOptions {
+    bool spriteTemplates = true;  ///< Place enemies (the RNG advances either way)
+    bool autotile = true;         ///< Replace plain ground with edge and corner tiles
+    // Called after each zone with the columns it covers; returning
+    // false abandons the level
+    std::function<bool(const Level& level, int x0, int x1)> zoneDone;
+};
+
+/// How likely a zone type is: base + perDifficulty * difficulty,
+/// clamped to [min, max], in the level types listed in typeMask
+struct ZoneWeight {
+    int base = 0;
+    int perDifficulty = 0;
+    int min = 0;
+    int max = 1 << 20;
+    int typeMask = 7;  ///< Bit per level type (1 << TYPE_*)
+    
+    int at(int difficulty, int type) const;
+};
+
 class LevelGenerator {
 public:
     static const int TYPE_OVERGROUND;
     static const int TYPE_UNDERGROUND;
     static const int TYPE_CASTLE;
     
-    static Level* createLevel(int width, int height, long seed, int difficulty, int type);
-    static Level* createBgLevel(int width, int height, bool distant, int type);
+    static Level* createLevel(int width, int height, int64_t seed, int difficulty, int type);
+    static Level* createBgLevel(int width, int height, bool distant, int type, int64_t seed);
+    
+    // Regenerate into an existing level, reusing its storage. The level's
+    // width and height are kept. Safe to call from any thread.
+    static void generateInto(Level* level, int64_t seed, int difficulty, int type);
+    // As above, with parts of generation skipped or checked per zone.
+    // Returns false if zoneDone abandoned the level (which is then only
+    // partly built). Skipping stages does not change the tiles that are
+    // built, so the same seed still describes the same level.
+    static bool generateInto(Level* level, int64_t seed, int difficulty, int type,
+                             const GenerateOptions& options);
+    
+    // Fill levels[i] from seeds[i] using `threads` worker threads (0 = one
+    // per core). The levels are caller-owned and may be reused between
+    // batches, so steady-state generation does not allocate.
+    static void generateBatch(const std::vector<int64_t>& seeds, int difficulty, int type,
+                              const std::vector<Level*>& levels, int threads = 0);
+    
+    // Replace the zone weights with those in an INI-style file (one
+    // [section] per zone type; see resources/zones.cfg). Zone types the
+    // file leaves out keep their built-in weights. On error the current
+    // weights are kept. Not thread-safe: call before generating levels.
+    static bool loadZoneConfig(const std::string& path);
+    // Same, reading from `in`; `name` is used in error messages
+    static bool loadZoneConfig(std::istream& in, const std::string& name);
+    static bool zoneConfigLoaded();
+    
+    static constexpr int ZONE_COUNT = 5;
+    
+    /// Cumulative odds over the zone types with a nonzero weight
+    struct ZoneOdds {
+        int total = 0;
+        int count = 0;
+        int end[ZONE_COUNT];        ///< Exclusive upper bound of each range
+        uint8_t zone[ZONE_COUNT];   ///< Index into ZONE_BUILDERS
+    };
 
 private:
-    static const int ODDS_STRAIGHT;
-    static const int ODDS_HILL_STRAIGHT;
-    static const int ODDS_TUBES;
-    static const int ODDS_JUMP;
-    static const int ODDS_CANNONS;
+    typedef int (LevelGenerator::*ZoneBuildFn)(int xo, int maxLength);
+    
+    /// A zone type the generator can build
+    struct ZoneBuilder {
+        const char* name;           ///< Section name in zones.cfg
+        ZoneBuildFn build;
+        ZoneWeight defaults;
+    };
+    // Zones are drawn from the odds in this order, so it is part of
+    // what a seed means: append new builders at the end
+    static const ZoneBuilder ZONE_BUILDERS[ZONE_COUNT];
+    friend struct ZoneTables;
+    friend class LevelStream;
     
     int width;
     int height;
     int type;
     int difficulty;
-    int totalOdds;
-    int odds[5];
+    const ZoneOdds* zoneOdds;
+    ZoneOdds oddsScratch;   ///< For difficulties outside the precompiled range
     Random random;
     Level* level;
+    bool placeSprites;
+    int ceiling;        ///< Castle/underground ceiling: current height
+    int ceilingRun;     ///< and columns left at that height
     
-    LevelGenerator(int width, int height);
-    Level* createLevelInternal(long seed, int difficulty, int type);
+    LevelGenerator();
+    // Clear `target` and get ready to build zones into it
+    void start(Level* target, int64_t seed, int difficulty, int type, bool sprites);
+    bool generate(Level* target, int64_t seed, int difficulty, int type,
+                  const GenerateOptions* options = nullptr);
     
     int buildZone(int x, int maxLength);
     int buildStraight(int xo, int maxLength, bool safe);
+    int buildStraightZone(int xo, int maxLength);
     int buildHillStraight(int xo, int maxLength);
     int buildTubes(int xo, int maxLength);
     int buildJump(int xo, int maxLength);
     int buildCannons(int xo, int maxLength);
+    void buildCeiling(int x0, int x1);
     void decorate(int x0, int x1, int floor);
     void addEnemyLine(int x0, int x1, int y);
-    void fixWalls();
 };
@@ -0,0 +1,124 @@
+/**
+ * @file LevelPack.h
+ * @brief Memory-mapped files of prebuilt levels.
+ * @ingroup level
+ *
+ * A level pack stores many levels indexed by (seed, difficulty, type),
+ * so a fixed evaluation corpus can be replayed without regenerating or
+ * parsing anything. The file is mapped once; the index and the levels
+ * are read in place through the structs below. A single level file is
+ * simply a pack with one entry.
+ *
+ * File layout (little-endian, as written by all supported targets):
+ *   Header
+ *   level records, each starting on an 8-byte boundary:
+ *     LevelHeader, u8 map[width * height],
+ *     u8 data[width * height] (only with LEVEL_HAS_DATA),
+ *     padding to 4 bytes, Template[templateCount]
+ *   Entry[levelCount], sorted by key (at Header::indexOffset)
+ *
+ * Tiles are stored column-major like Level::map, so loading a level is
+ * a memcpy plus one addSpriteTemplate() per enemy. Freshly generated
+ * levels have no bump data, so it is left out and reads as zero.
+ */
+#pragma once
+#include "Common.h"
+#include "LevelPregenerator.h"
+#include "MappedFile.h"
+#include <cstdio>
+
+class Level;
+
+class LevelPack {
+public:
+    static constexpr uint32_t MAGIC = 0x504c5854;  // "TXLP"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t LEVEL_HAS_DATA = 1 << 0;  ///< LevelHeader::flags
+    
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t levelCount;
+        uint32_t reserved;
+        uint64_t indexOffset;
+    };
+    
+    struct Entry {
+        int64_t seed;
+        int32_t difficulty;
+        int32_t type;
+        uint64_t offset;  ///< Start of the level record
+        uint64_t size;    ///< Bytes in the record
+        
+        LevelKey key() const { return {seed, difficulty, type}; }
+    };
+    
+    struct LevelHeader {
+        int32_t width;
+        int32_t height;
+        int32_t xExit;
+        int32_t yExit;
+        uint32_t templateCount;
+        uint32_t flags;
+    };
+    
+    /// A sprite template of a stored level
+    struct Template {
+        uint32_t cell;  ///< x * height + y
+        int16_t type;
+        uint8_t winged;
+        uint8_t reserved;
+    };
+    
+    /// One stored level, pointing into the mapped file
+    struct View {
+        const LevelHeader* header = nullptr;
+        const uint8_t* map = nullptr;
+        const uint8_t* data = nullptr;  ///< nullptr if all zero
+        const Template* templates = nullptr;
+    };
+    
+    // Map a pack and check its header and index; false (with a message
+    // on stderr) if it is missing or malformed
+    bool open(const std::string& path);
+    
+    size_t size() const { return count; }
+    const Entry& entry(size_t i) const { return index[i]; }
+    // Binary search of the index; nullptr if the key is not stored
+    const Entry* find(const LevelKey& key) const;
+    
+    // Locate a record in the file; false if it does not fit there
+    bool view(const Entry& entry, View& out) const;
+    // Copy a stored level into `level`, which must have the same size
+    static bool loadInto(const View& view, Level* level);
+    // New level for `key`, or nullptr if the pack does not hold it
+    Level* load(const LevelKey& key) const;
+
+private:
+    MappedFile file;
+    const Entry* index = nullptr;
+    size_t count = 0;
+};
+
+/**
+ * Writes a pack one level at a time; the index is added by finish().
+ */
+class LevelPackWriter {
+public:
+    ~LevelPackWriter();
+    
+    bool open(const std::string& path);
+    // Append a level. A key that was already added keeps its first level.
+    bool add(const LevelKey& key, const Level* level);
+    // Write the index and close the file; false on I/O errors
+    bool finish();
+
+private:
+    FILE* out = nullptr;
+    uint64_t offset = 0;
+    bool failed = false;
+    std::vector<LevelPack::Entry> entries;
+    
+    void writeBytes(const void* bytes, size_t size);
+    void pad(size_t alignment);
+};
@@ -0,0 +1,70 @@
+/**
+ * @file LevelPregenerator.h
+ * @brief Builds upcoming levels on a worker thread.
+ * @ingroup level
+ *
+ * While the player walks the world map, MapScene asks for the levels
+ * it can reach next. A single worker thread generates the level and
+ * both background layers for each one, so that entering a level only
+ * hands over finished objects instead of generating them on the main
+ * thread.
+ */
+#pragma once
+#include "Common.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class Level;
+
+/// Parameters that fully determine a generated level
+struct LevelKey {
+    int64_t seed;
+    int difficulty;
+    int type;
+    
+    bool operator==(const LevelKey& other) const {
+        return seed == other.seed && difficulty == other.difficulty && type == other.type;
+    }
+};
+
+/// A level plus its two background layers (distant, near). Whoever
+/// holds it owns the pointers.
+struct PregeneratedLevel {
+    Level* level = nullptr;
+    Level* bgLevels[2] = {nullptr, nullptr};
+    
+    void destroy();
+};
+
+class LevelPregenerator {
+public:
+    LevelPregenerator(int width, int height);
+    ~LevelPregenerator();
+    
+    // Replace the wanted set, highest priority first. Finished levels
+    // that are no longer wanted are freed; queued ones are dropped.
+    void request(const std::vector<LevelKey>& keys);
+    
+    // Hand over a finished level. If the worker is building this exact
+    // level right now, waits for it. Returns false if it was never
+    // requested, in which case the caller generates it itself.
+    bool take(const LevelKey& key, PregeneratedLevel& out);
+
+private:
+    int width, height;
+    
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wakeWorker;
+    std::condition_variable levelFinished;
+    
+    std::vector<LevelKey> wanted;  ///< Last requested set
+    std::vector<LevelKey> queue;
+    std::vector<std::pair<LevelKey, PregeneratedLevel>> ready;
+    LevelKey current{0, 0, 0};
+    bool building = false;
+    bool stopping = false;
+    
+    void workerLoop();
+};
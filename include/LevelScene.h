@@ -14,8 +14,12 @@
 class Level;
 class Mario;
 class Sprite;
+class SpriteTemplate;
 class LevelRenderer;
 class BgRenderer;
+class LevelStream;
+class StateWriter;
+class StateReader;
 
 class LevelScene : public Scene {
 public:
@@ -33,10 +37,42 @@ public:
     int timeLeft = 0;
     int fireballsOnScreen = 0;
     
-    LevelScene(Game* game, long seed, int levelDifficulty, int type);
+    /// Scene RNG for effects, seeded from the level seed so that a
+    /// savestate reproduces the same sparkles and debris after loading.
+    Random random;
+    
+    /// Size of generated levels, in tiles
+    static constexpr int LEVEL_WIDTH = 320;
+    static constexpr int LEVEL_HEIGHT = 15;
+    
+    /// Endless levels: columns beyond the camera before more are built,
+    /// and columns behind it before they are retired
+    static constexpr int ENDLESS_LOOKAHEAD = 48;
+    static constexpr int ENDLESS_KEEP_BEHIND = 64;
+    /// Endless levels are renumbered by this many columns at a time to
+    /// keep coordinates small (see LevelStream::shift)
+    static constexpr int ENDLESS_REBASE_COLUMNS = 16384;
+    
+    // An endless scene streams its level (see LevelStream) instead of
+    // generating a fixed one; it has no exit and no time limit
+    LevelScene(Game* game, int64_t seed, int levelDifficulty, int type, bool endless = false);
     ~LevelScene();
     
+    bool isEndless() const { return endless; }
+    // Columns travelled from the start of an endless level
+    int64_t endlessDistance() const;
+    
+    // Hand over a level (and optionally its backgrounds) that was built
+    // ahead of time. Call before init(); the scene takes ownership.
+    void adoptLevel(Level* level, Level* bgDistant, Level* bgNear);
+    
+    // Width of the level to generate, in tiles (LEVEL_WIDTH by default).
+    // Call before init(); the time limit grows with the width.
+    void setLevelWidth(int width) { levelWidth = width; }
+    
     void init() override;
+    // init() without starting the level music, for headless tools
+    void initLevel();
     void tick() override;
     void render(SDL_Renderer* renderer, float alpha) override;
     void handleTestKey(char key) override;
@@ -50,20 +86,57 @@ public:
     void checkShellCollide(Sprite* shell);
     void checkFireballCollide(Sprite* fireball);
     void convertEnemiesToCoins();  // Convert all enemies to coins when level is won
+    
+    // Savestate support (see SaveState.h). readState() is called on a
+    // freshly constructed scene instead of init(), or on a running scene
+    // to replace its contents.
+    void writeState(StateWriter& out) const;
+    bool readState(StateReader& in);
+    
+    // The two halves of a savestate: level tiles (rarely change) and
+    // everything else
+    void writeLevelState(StateWriter& out) const;
+    void writeDynamicState(StateWriter& out) const;
+    bool readLevelState(StateReader& in);
+    bool readDynamicState(StateReader& in);
+    
+    // What Rewind keeps per tick: the dynamic state without the sprite
+    // templates, which stay in the level (their changes are undone from
+    // Level::editLog). The size depends on the sprites, not the level.
+    void writeRewindState(StateWriter& out) const;
+    bool readRewindState(StateReader& in);
 
 private:
     LevelRenderer* layer = nullptr;
     BgRenderer* bgLayer[2] = {nullptr, nullptr};
+    Level* adoptedBgLevels[2] = {nullptr, nullptr};  ///< Consumed by createBgLayers()
+    
+    bool endless = false;
+    int levelWidth = LEVEL_WIDTH;
+    LevelStream* stream = nullptr;  ///< Owns `level` when set
     
     int tickCount = 0;
     bool isFast = false;
     bool isMusicStopped = false;
     
-    long levelSeed;
+    int64_t levelSeed;
     int levelType;
     int musicType;
     int levelDifficulty;
     
+    void createLayers();
+    void createBgLayers();
+    void clearState();
+    void clearSprites();
+    
+    typedef std::vector<std::pair<SpriteTemplate*, int32_t>> TemplateLinks;  ///< Template, sprite index
+    static int32_t indexOfSprite(const std::vector<Sprite*>& all, const Sprite* sprite);
+    void writeSpriteState(StateWriter& out, const std::vector<Sprite*>& all) const;
+    bool readSpriteState(StateReader& in, const TemplateLinks& templateSprites);
+    void startLevelMusic();
+    void updateStream();
+    void rebase(int columns);
+    
     // Iris wipe (blackout) rendering - matches Java implementation
     void renderBlackout(SDL_Renderer* renderer, int x, int y, int radius);
 };
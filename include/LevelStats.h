@@ -0,0 +1,80 @@
+/**
+ * @file LevelStats.h
+ * @brief Per-level statistics for difficulty calibration.
+ * @ingroup level
+ *
+ * LevelStats summarizes a generated level: gaps, enemies by type,
+ * cannons, tubes, coins and blocks, and how much the floor height
+ * varies. Tile counts come from one histogram pass over the flat tile
+ * array and the gap and floor figures from one pass over the bottom of
+ * each column, so measuring a level costs far less than generating it.
+ *
+ * Columns can be added a range at a time while a level is being built
+ * (see GenerateOptions::zoneDone), which is how SeedSearch rejects
+ * seeds before their level is finished.
+ *
+ * collect() generates and measures a whole seed range on every core
+ * and streams the results as CSV, one row per level.
+ */
+#pragma once
+#include "Common.h"
+#include <cstdio>
+
+class Level;
+
+struct LevelStats {
+    int64_t seed = 0;
+    int type = 0;
+    int difficulty = 0;
+    int width = 0;
+
+    int gaps = 0;                ///< Runs of columns with no ground
+    int gapMaxWidth = 0;
+    float gapMeanWidth = 0;
+
+    int enemies[5] = {};         ///< Indexed by Enemy::ENEMY_* (flowers included)
+    int winged = 0;
+
+    int cannons = 0;
+    int tubes = 0;
+    int coins = 0;
+    int questionBlocks = 0;
+    int hiddenBlocks = 0;
+    int bricks = 0;
+
+    float floorMean = 0;         ///< Ground height in tiles, over non-gap columns
+    float floorVariance = 0;
+
+    static LevelStats measure(const Level* level);
+
+    // Incremental measuring: add columns [x0, x1) in left-to-right order,
+    // then finish() once to close the last gap and compute the averages
+    void addColumns(const Level* level, int x0, int x1);
+    void finish();
+
+    // Generate `count` seeds from `firstSeed` in every level type, using
+    // `threads` workers (0 = one per core), and write one CSV row per
+    // level to `out` in seed order
+    static void collect(int64_t firstSeed, int64_t count, int difficulty, int threads, FILE* out);
+
+    static void writeCsvHeader(FILE* out);
+    void writeCsv(FILE* out) const;
+
+    // Named access to the CSV columns, for filters such as SeedSearch
+    static int fieldCount();
+    static const char* fieldName(int field);
+    static int findField(const std::string& name);  ///< -1 if unknown
+    // True if the field can only grow as more columns are added
+    static bool fieldGrows(int field);
+    // True if the field depends on sprite templates
+    static bool fieldNeedsSprites(int field);
+    double field(int field) const;
+
+private:
+    // Running totals between addColumns() and finish()
+    int gapRun = 0;
+    int gapTotal = 0;
+    int groundColumns = 0;
+    double floorSum = 0;
+    double floorSquares = 0;
+};
@@ -0,0 +1,60 @@
+/**
+ * @file LevelStream.h
+ * @brief Endless level built zone by zone as it is played.
+ * @ingroup level
+ *
+ * LevelStream drives LevelGenerator one zone at a time into a Level
+ * whose columns live in a fixed ring (Level::wrapColumns). Zones are
+ * added as the camera nears the right end of the built columns, and
+ * columns far enough behind are retired: their tiles, bump data and
+ * sprite templates are cleared and the ring slots are reused for the
+ * columns that follow. Memory and the per-tick cost of the level stay
+ * the same however far the player runs.
+ *
+ * Column numbers keep growing as the stream advances. shift() moves
+ * them back by a multiple of the ring size, which leaves the ring
+ * untouched, so that pixel coordinates stay small enough for float
+ * precision.
+ */
+#pragma once
+#include "Common.h"
+#include "LevelGenerator.h"
+
+class Level;
+
+class LevelStream {
+public:
+    /// Columns stored at once (retired columns included)
+    static constexpr int RING_COLUMNS = 256;
+    /// No zone is longer than this (the longest builders stop near 20)
+    static constexpr int MAX_ZONE_LENGTH = 32;
+    
+    LevelStream(int height, int64_t seed, int difficulty, int type);
+    ~LevelStream();
+    LevelStream(const LevelStream&) = delete;
+    LevelStream& operator=(const LevelStream&) = delete;
+    
+    /// The ring level; owned by the stream
+    Level* getLevel() const { return level; }
+    
+    // Retire the columns before xKeep, then build zones until columns up
+    // to xNeeded exist or the ring is full. Live sprites must already
+    // have let go of templates in the retired columns.
+    void advance(int xNeeded, int xKeep);
+    
+    // Renumber every column `columns` lower (a multiple of RING_COLUMNS,
+    // no more than Level::firstColumn)
+    void shift(int columns);
+    
+    // Columns removed by shift() so far, to turn a column number into a
+    // distance from the start
+    int64_t shiftedColumns() const { return shifted; }
+
+private:
+    LevelGenerator generator;
+    Level* level;
+    int type;
+    int64_t shifted = 0;
+    
+    void finishColumns(int x0, int x1);
+};
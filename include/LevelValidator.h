@@ -0,0 +1,44 @@
+/**
+ * @file LevelValidator.h
+ * @brief Reachability check for generated levels.
+ * @ingroup level
+ *
+ * LevelValidator decides whether Mario can get from the spawn point to
+ * the exit of a level. It runs a breadth-first search over the cells
+ * Mario can stand in; from each cell it walks to the neighbours, drops
+ * off ledges and tries a fixed set of jump arcs.
+ *
+ * The arcs are simulated once with the same constants Mario::move uses
+ * (jump speed, gravity, air inertia, run acceleration) and stored as a
+ * prefix tree of tile cells relative to the take-off cell. Each column
+ * of the level becomes a bitmask of blocking rows, so following an arc
+ * costs one mask test per step and a standard 320x15 level validates
+ * in a fraction of a millisecond.
+ *
+ * The search is conservative: an arc that bumps into a wall or ceiling
+ * is abandoned instead of followed along the wall, and enemies are
+ * ignored. A level it accepts is winnable; a level it rejects is very
+ * likely not.
+ */
+#pragma once
+#include "Common.h"
+
+class Level;
+
+struct ValidationResult {
+    bool reachable = false;  ///< Mario can cross xExit
+    int stuckX = 0;          ///< Right-most cell Mario can stand in
+    int stuckY = 0;
+    int cellsVisited = 0;
+};
+
+class LevelValidator {
+public:
+    // Columns are searched as 64-bit row masks
+    static constexpr int MAX_HEIGHT = 64;
+    
+    // Check whether the exit of `level` can be reached. `large` uses
+    // big Mario's two-tile body, which matters under low ceilings.
+    // Levels taller than MAX_HEIGHT are reported as unreachable.
+    static ValidationResult validate(const Level* level, bool large = false);
+};
@@ -7,6 +7,7 @@
  */
 #pragma once
 #include "Scene.h"
+#include "Art.h"
 
 class LoseScene : public Scene {
 public:
@@ -18,4 +19,5 @@ public:
 private:
     int tickCount = 0;
     bool wasDown = true;  ///< Prevents immediate trigger if key held from previous scene
+    AssetHandle gameOver{ASSET_GAME_OVER};
 };
@@ -8,12 +8,14 @@
  */
 #pragma once
 #include "Scene.h"
+#include "Art.h"
 #include "Common.h"
+#include "LevelPregenerator.h"
 #include <vector>
 
 class MapScene : public Scene {
 public:
-    MapScene(Game* game, long seed);
+    MapScene(Game* game, int64_t seed);
     
     void init() override;
     void tick() override;
@@ -21,6 +23,14 @@ public:
     
     void startMusic();
     void levelWon();
+    // Free the world map sheet until the next init()
+    void releaseArt() { worldMap.reset(); }
+    
+    // Seeds derived from the world seed for the level node at (x, y).
+    // Arithmetic wraps like Java's long, so every platform gets the same
+    // levels for the same world.
+    static int64_t levelSeedAt(int64_t worldSeed, int x, int y);
+    static int64_t levelTypeSeedAt(int64_t worldSeed, int x, int y);
 
 private:
     // Tile type constants
@@ -30,7 +40,7 @@ private:
     static constexpr int TILE_ROAD = 3;
     static constexpr int TILE_DECORATION = 4;
     
-    long seed;
+    int64_t seed;
     Random random;
     
     int tickCount = 0;
@@ -45,10 +55,12 @@ private:
     int yFarthestCap = 0;
     
     bool canEnterLevel = false;
+    int xPregen = -1, yPregen = -1;  ///< Tile the pregeneration request was made for
     
     // Map data - generated procedurally
     std::vector<std::vector<int>> level;
     std::vector<std::vector<int>> data;
+    AssetHandle worldMap;  ///< Held from init() until releaseArt()
     
     void nextWorld();
     bool generateLevel();
@@ -62,4 +74,6 @@ private:
     void drawStringDropShadow(const std::string& text, int x, int y, int c);
     bool isRoad(int x, int y);
     bool isWater(int x, int y);
+    bool levelAt(int x, int y, LevelKey& key, std::string& levelString) const;
+    void requestNearbyLevels(int x, int y);
 };
@@ -0,0 +1,37 @@
+/**
+ * @file MappedFile.h
+ * @brief Read-only memory mapping of a whole file.
+ * @ingroup core
+ *
+ * The file's pages are shared with the OS page cache, so opening a
+ * large file costs one system call and only the parts that are read
+ * are loaded from disk.
+ */
+#pragma once
+#include "Common.h"
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    // Map `path`, replacing any previous mapping; false if it cannot be
+    // opened. Empty files map to an empty range.
+    bool open(const std::string& path);
+    void close();
+    
+    bool isOpen() const { return opened; }
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
@@ -37,6 +37,19 @@ public:
     static constexpr int KEY_JUMP = 4;
     static constexpr int KEY_SPEED = 5;
     
+    // Movement constants (also used by LevelValidator's jump arcs)
+    static constexpr float GROUND_INERTIA = 0.89f;
+    static constexpr float AIR_INERTIA = 0.89f;
+    static constexpr float WALK_ACCELERATION = 0.6f;
+    static constexpr float RUN_ACCELERATION = 1.2f;
+    static constexpr float JUMP_SPEED = -1.9f;   ///< Per tick of jumpTime left
+    static constexpr int JUMP_TIME = 7;          ///< Ticks a held jump keeps rising
+    static constexpr float VERTICAL_DAMPING = 0.85f;
+    static constexpr float GRAVITY = 3.0f;
+    static constexpr int WIDTH = 4;              ///< Half-width of the collision box
+    static constexpr int SMALL_HEIGHT = 12;
+    static constexpr int LARGE_HEIGHT = 24;
+    
     bool* keys;
     int facing = 1;
     
@@ -68,15 +81,16 @@ public:
     // Public for collision checks
     bool wasOnGround = false;
     bool onGround = false;
-    int height = 24;
+    int height = LARGE_HEIGHT;
     
     // Made public for test mode (normally only called internally)
     void setLarge(bool large, bool fire);
 
+    SpriteKind getKind() const override { return SpriteKind::MARIO; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
-    static constexpr float GROUND_INERTIA = 0.89f;
-    static constexpr float AIR_INERTIA = 0.89f;
-    
     float runTime = 0;
     bool mayJump = false;
     bool ducking = false;
@@ -86,7 +100,7 @@ private:
     float yJumpSpeed = 0;
     bool canShoot = false;
     
-    int width = 4;
+    int width = WIDTH;
     
     LevelScene* world;
     int powerUpTime = 0;
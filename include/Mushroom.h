@@ -18,6 +18,10 @@ public:
     void collideCheck() override;
     void bumpCheck(int xTile, int yTile) override;
 
+    SpriteKind getKind() const override { return SpriteKind::MUSHROOM; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     LevelScene* world;
     int facing = 1;
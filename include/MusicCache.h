@@ -0,0 +1,39 @@
+/**
+ * @file MusicCache.h
+ * @brief MIDI tracks rendered to WAV files ahead of time.
+ * @ingroup core
+ *
+ * SDL_mixer cannot reliably rewind a MIDI track, so every level start
+ * freed the track, loaded it again and had FluidSynth load the
+ * soundfont again. When built with INFINITE_TUX_RENDER_MUSIC, a worker
+ * thread renders each track once with FluidSynth into the cache
+ * directory, and Art plays and restarts the rendered file instead.
+ *
+ * A rendered file is named after a hash of everything that changes its
+ * sound: the MIDI data, the soundfont path and the synth setting. A new
+ * user override or soundfont simply renders a new file. Tracks are
+ * rendered at 44.1 kHz stereo, about 10 MB a minute.
+ *
+ * Until a track has been rendered, and in builds without FluidSynth,
+ * the MIDI file is played as before.
+ */
+#pragma once
+#include "Common.h"
+
+class MusicCache {
+public:
+    // False in builds without FluidSynth; the other calls do nothing
+    static bool available();
+
+    // Directory for rendered files, ending in a slash ("" turns the
+    // cache off). It must exist.
+    static void setDirectory(const std::string& directory);
+
+    // Path of the rendered file for a track, or "" if it is not there
+    // yet, in which case it is queued for rendering. `midi` is the
+    // track's file contents and `soundfont` the path FluidSynth loads.
+    static std::string find(const std::string& midi, const std::string& soundfont, int synth);
+
+    // Stop rendering (a partly rendered track is thrown away)
+    static void shutdown();
+};
@@ -9,12 +9,18 @@
 #pragma once
 #include "Sprite.h"
 
+class LevelScene;
+
 class Particle : public Sprite {
 public:
-    Particle(int x, int y, float xa, float ya);
+    Particle(LevelScene* world, int x, int y, float xa, float ya);
     Particle(int x, int y, float xa, float ya, int xPic, int yPic);
     void move() override;
 
+    SpriteKind getKind() const override { return SpriteKind::PARTICLE; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     int life = 10;
 };
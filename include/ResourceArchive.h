@@ -0,0 +1,112 @@
+/**
+ * @file ResourceArchive.h
+ * @brief Single-file archive of the game's images, sounds and music.
+ * @ingroup core
+ *
+ * An installation can ship resources/resources.pak instead of the loose
+ * sheets, sound effects and MIDI files. The archive is mapped once;
+ * stored entries are handed to SDL_image and SDL_mixer straight from
+ * the mapping through SDL_RWops, and LZ4 entries are decompressed into
+ * a buffer the SDL_RWops owns. Files in the user data directory still
+ * take priority (see Art::openResource).
+ *
+ * Files that are read by path stay loose: zones.cfg, tiles.dat,
+ * level-hashes.txt and soundfonts (FluidSynth opens those itself).
+ *
+ * File layout (little-endian, as written by all supported targets):
+ *   Header
+ *   entry data, each starting on an 8-byte boundary
+ *   names (not NUL-terminated)
+ *   Entry[entryCount], sorted by name (at Header::indexOffset)
+ *
+ * Compressed entries are single LZ4 blocks (the format of
+ * LZ4_compress_default), so they can also be produced by other tools.
+ */
+#pragma once
+#include "Common.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <string_view>
+
+class ResourceArchive {
+public:
+    static constexpr uint32_t MAGIC = 0x41525854;  // "TXRA"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr const char* FILE_NAME = "resources.pak";
+
+    enum Method : uint32_t {
+        STORED = 0,
+        LZ4 = 1
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+        uint64_t indexOffset;
+    };
+
+    struct Entry {
+        uint64_t offset;        ///< Start of the data
+        uint64_t size;          ///< Bytes in the archive
+        uint64_t originalSize;  ///< Bytes once decompressed
+        uint64_t hash;          ///< FNV-1a of the original bytes
+        uint64_t nameOffset;
+        uint32_t nameLength;
+        uint32_t method;
+    };
+
+    // Map an archive and check its header and index; false (with a
+    // message on stderr) if it is missing or malformed
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    size_t size() const { return count; }
+    const Entry& entry(size_t i) const { return index[i]; }
+    std::string_view name(const Entry& entry) const;
+    // Binary search of the index; nullptr if there is no such entry
+    const Entry* find(std::string_view name) const;
+
+    // The original bytes of an entry; false if the entry is damaged
+    bool read(const Entry& entry, std::vector<uint8_t>& out) const;
+    // Reader for SDL (close it, or pass freesrc = 1 to the loader).
+    // Stored entries are read in place, so the archive must stay open
+    // while the SDL_RWops or anything loaded lazily from it is in use.
+    SDL_RWops* openRW(const Entry& entry) const;
+
+    static uint64_t hashBytes(const uint8_t* bytes, size_t size);
+
+private:
+    MappedFile file;
+    const Entry* index = nullptr;
+    size_t count = 0;
+
+    bool inFile(const Entry& entry) const;
+};
+
+/**
+ * Writes an archive one file at a time; the index is added by finish().
+ */
+class ResourceArchiveWriter {
+public:
+    ~ResourceArchiveWriter();
+
+    bool open(const std::string& path);
+    // Append a file, LZ4-compressed if that saves at least 1/16 of it
+    bool add(const std::string& name, const std::vector<uint8_t>& bytes);
+    // Write the names and the index and close the file; false on I/O
+    // errors or if a name was added twice
+    bool finish();
+
+private:
+    FILE* out = nullptr;
+    uint64_t offset = 0;
+    bool failed = false;
+    std::vector<ResourceArchive::Entry> entries;
+    std::vector<std::string> names;
+
+    void writeBytes(const void* bytes, size_t size);
+    void pad(size_t alignment);
+};
@@ -0,0 +1,41 @@
+/**
+ * @file ResourceIndex.h
+ * @brief In-memory listing of the resource directories.
+ * @ingroup core
+ *
+ * Every resource lookup used to open the file it was asking about: the
+ * user override check for each image, sound and music track, the probes
+ * for the resources directory and the soundfont check on every music
+ * start. ResourceIndex lists a directory once, the first time a path in
+ * it is asked about, and answers later questions from a hash set.
+ * Art::init lists the user data and system resource trees up front.
+ *
+ * Listings are kept for the rest of the run. When built with
+ * INFINITE_TUX_WATCH_RESOURCES on Linux, watch() puts an inotify watch
+ * on each listed directory and poll() drops the listings of directories
+ * that changed, so a file dropped into the user data directory is seen
+ * without a restart.
+ */
+#pragma once
+#include "Common.h"
+
+class ResourceIndex {
+public:
+    // True if `path` is a file (or a link to one)
+    static bool exists(const std::string& path);
+
+    // List `dir` (ending in a slash) and the directories below it now
+    static void preload(const std::string& dir);
+    // Every file below `dir`, relative to it ("snd/coin.wav"), sorted
+    static std::vector<std::string> listFiles(const std::string& dir);
+
+    // Watch listed directories for changes. False if watching is not
+    // available in this build or the watch could not be set up.
+    static bool watch();
+    // Forget the listings of directories that changed; cheap when
+    // nothing did. Call once per frame.
+    static void poll();
+
+    // Drop all listings and stop watching
+    static void clear();
+};
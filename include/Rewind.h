@@ -0,0 +1,67 @@
+/**
+ * @file Rewind.h
+ * @brief Bounded in-memory rewind buffer for LevelScene.
+ * @ingroup level
+ *
+ * Rewind records one frame per gameplay tick. Each frame holds
+ *   - the level changes made during that tick (Level::editLog: tiles,
+ *     bump data and sprite template state, with the values they
+ *     replaced), and
+ *   - the rewind state of the scene (sprites, Mario, timers, RNG; see
+ *     LevelScene::writeRewindState). Every keyframeInterval ticks this
+ *     is a full copy; in between only the byte ranges that differ from
+ *     the previous tick are kept.
+ *
+ * Restoring a tick undoes the level changes of the newer frames, newest
+ * first, and rebuilds the rest from the nearest keyframe at or before
+ * it plus at most keyframeInterval - 1 deltas. Nothing recorded grows
+ * with the size of the level. Once the buffer holds more than the
+ * requested number of seconds, the oldest keyframe and its deltas are
+ * dropped together, so memory stays bounded.
+ */
+#pragma once
+#include "Common.h"
+#include "Level.h"
+#include <deque>
+
+class LevelScene;
+
+class Rewind {
+public:
+    Rewind(int seconds = 10, int keyframeInterval = TICKS_PER_SECOND);
+    
+    // Drop all recorded frames (call when a different level starts)
+    void clear();
+    
+    // Record the scene's state after a tick
+    void record(LevelScene* scene);
+    
+    // Roll the scene back ticksBack recorded ticks (clamped to the oldest
+    // one available) and discard the newer frames. Returns false if
+    // nothing has been recorded or the state could not be rebuilt.
+    bool restore(LevelScene* scene, int ticksBack);
+    
+    int ticksAvailable() const { return frames.empty() ? 0 : (int)frames.size() - 1; }
+    size_t memoryUsed() const;
+
+private:
+    struct Frame {
+        bool keyframe = false;
+        bool fullDynamic = false;             ///< dynamicState is a full copy, not a diff
+        std::vector<uint8_t> dynamicState;
+        std::vector<Level::TileEdit> tileEdits;  ///< Made during the tick that led here
+    };
+    
+    std::deque<Frame> frames;
+    int maxFrames;
+    int keyframeInterval;
+    int ticksSinceKeyframe = 0;
+    
+    const LevelScene* lastScene = nullptr;
+    std::vector<uint8_t> lastDynamic;           ///< Full dynamic state of the newest frame
+    std::vector<Level::TileEdit> pendingEdits;  ///< Level::editLog target
+    
+    static void encodeDiff(const std::vector<uint8_t>& prev, const std::vector<uint8_t>& cur,
+                           std::vector<uint8_t>& out);
+    static bool applyDiff(std::vector<uint8_t>& state, const std::vector<uint8_t>& diff);
+};
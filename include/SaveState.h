@@ -0,0 +1,121 @@
+/**
+ * @file SaveState.h
+ * @brief Binary savestates for in-level gameplay.
+ * @ingroup level
+ *
+ * A savestate captures everything needed to resume a LevelScene
+ * exactly: level tiles and bump data, sprite templates, the live
+ * sprite list, Mario's static and per-level state, timers and the
+ * scene RNG.
+ *
+ * File layout (little-endian, as written by all supported targets):
+ *   u32 magic ("TXSV"), u32 version, u32 payload size, payload
+ *
+ * Values are appended with memcpy into a single buffer and the tile
+ * arrays are copied in bulk, so saving is one write() and loading is
+ * one read().
+ */
+#pragma once
+#include "Common.h"
+#include <cstring>
+#include <type_traits>
+
+class Game;
+class LevelScene;
+
+/**
+ * Append-only binary writer backed by a byte vector.
+ */
+class StateWriter {
+public:
+    std::vector<uint8_t> buffer;
+
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "StateWriter::write needs a POD type");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeBytes(const void* src, size_t size) {
+        size_t pos = buffer.size();
+        buffer.resize(pos + size);
+        if (size > 0) std::memcpy(buffer.data() + pos, src, size);
+    }
+
+    void writeString(const std::string& str) {
+        write<uint32_t>((uint32_t)str.size());
+        writeBytes(str.data(), str.size());
+    }
+};
+
+/**
+ * Bounds-checked reader over a byte range. Once a read runs past the
+ * end, good() turns false and all further reads return zero.
+ */
+class StateReader {
+public:
+    StateReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value, "StateReader::read needs a POD type");
+        static_assert(!std::is_same<T, bool>::value, "Use StateReader::readBool for flags");
+        T value{};
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+
+    // Flags are stored as one byte; anything but 0 or 1 marks the data bad
+    bool readBool() {
+        uint8_t value = read<uint8_t>();
+        if (value > 1) ok = false;
+        return value != 0;
+    }
+
+    bool readBytes(void* dst, size_t count) {
+        if (!ok || count > size - pos) {
+            ok = false;
+            if (count > 0) std::memset(dst, 0, count);
+            return false;
+        }
+        if (count > 0) std::memcpy(dst, data + pos, count);
+        pos += count;
+        return true;
+    }
+
+    std::string readString() {
+        uint32_t length = read<uint32_t>();
+        if (!ok || length > size - pos) {
+            ok = false;
+            return "";
+        }
+        std::string str(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return str;
+    }
+
+    bool good() const { return ok; }
+    size_t remaining() const { return size - pos; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+};
+
+class SaveState {
+public:
+    static constexpr uint32_t MAGIC = 0x56535854;  // "TXSV"
+    static constexpr uint32_t VERSION = 1;
+
+    // Write the scene to path. Returns false on I/O failure.
+    static bool save(const LevelScene* scene, const std::string& path);
+
+    // Build a new LevelScene from path, or nullptr if the file is
+    // missing, truncated, or from an incompatible version.
+    static LevelScene* load(Game* game, const std::string& path);
+
+    // Default quicksave location in the user data directory
+    static std::string quickSavePath();
+};
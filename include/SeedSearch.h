@@ -0,0 +1,63 @@
+/**
+ * @file SeedSearch.h
+ * @brief Scans seed ranges for levels with given properties.
+ * @ingroup level
+ *
+ * SeedSearch generates levels on every core and keeps the seeds whose
+ * LevelStats satisfy a predicate. Generation runs in a reduced mode:
+ * ground autotiling is skipped (statistics do not depend on it) and
+ * enemies are only placed when the predicate looks at them.
+ *
+ * The predicate is also called after every zone with statistics for
+ * the part of the level built so far, so a seed that already has too
+ * many cannons or too wide a gap is dropped without building the rest.
+ */
+#pragma once
+#include "Common.h"
+#include <functional>
+
+class Level;
+struct LevelStats;
+
+/**
+ * Decide on a level from its statistics. While the level is still being
+ * built `complete` is false and the statistics cover the zones so far;
+ * return false to drop the seed early, or true if it may still match.
+ */
+typedef std::function<bool(const LevelStats& stats, bool complete)> SeedPredicate;
+
+/// One comparison against a LevelStats field, such as "cannons>6"
+struct SeedCondition {
+    enum Op { LESS, LESS_EQUAL, EQUAL, NOT_EQUAL, GREATER_EQUAL, GREATER };
+
+    int field = 0;     ///< LevelStats field index
+    Op op = EQUAL;
+    double value = 0;
+
+    // Parse "name<op>value"; false if the field or operator is unknown
+    static bool parse(const std::string& text, SeedCondition& out);
+
+    bool test(double actual) const;
+    // True once a partly built level can no longer satisfy the condition
+    bool failsEarly(const LevelStats& partial) const;
+};
+
+class SeedSearch {
+public:
+    int difficulty = 0;
+    int type = 0;
+    SeedPredicate predicate;
+    bool needsSprites = true;  ///< Whether the predicate reads enemy counts
+    int threads = 0;           ///< 0 = one per core
+    size_t maxMatches = 0;     ///< Stop after this many matches (0 = no limit)
+
+    // Predicate that requires every condition to hold
+    void setConditions(const std::vector<SeedCondition>& conditions);
+
+    // Scan `count` seeds from `firstSeed` and return the matches in
+    // ascending order. `scanned` receives how many seeds were examined.
+    std::vector<int64_t> run(int64_t firstSeed, int64_t count, int64_t* scanned = nullptr) const;
+
+    // Test one seed, reusing `level` (which must be caller-owned scratch)
+    bool matches(int64_t seed, Level* level, LevelStats& stats) const;
+};
@@ -30,6 +30,10 @@ public:
     bool shellCollideCheck(Shell* shell) override;
     void die();
 
+    SpriteKind getKind() const override { return SpriteKind::SHELL; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     LevelScene* world;
     int type;
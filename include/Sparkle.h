@@ -9,11 +9,17 @@
 #pragma once
 #include "Sprite.h"
 
+class LevelScene;
+
 class Sparkle : public Sprite {
 public:
-    Sparkle(int x, int y, float xa, float ya, int xPic, int yPic, int life);
+    Sparkle(LevelScene* world, int x, int y, float xa, float ya, int xPic, int yPic, int life);
     void move() override;
 
+    SpriteKind getKind() const override { return SpriteKind::SPARKLE; }
+    void writeState(StateWriter& out) const override;
+    void readState(StateReader& in) override;
+
 private:
     int life;
     int xPicStart;
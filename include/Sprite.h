@@ -15,6 +15,24 @@ class Shell;
 class Fireball;
 class Mario;
 class LevelScene;
+class StateWriter;
+class StateReader;
+
+// Concrete sprite class, recorded in savestates so sprites can be rebuilt
+enum class SpriteKind : uint8_t {
+    SPRITE,
+    MARIO,
+    ENEMY,
+    FLOWER_ENEMY,
+    SHELL,
+    FIREBALL,
+    BULLET_BILL,
+    MUSHROOM,
+    FIRE_FLOWER,
+    PARTICLE,
+    SPARKLE,
+    COIN_ANIM
+};
 
 class Sprite {
 public:
@@ -51,4 +69,11 @@ public:
     virtual bool shellCollideCheck(Shell* shell);
     virtual void release(Mario* mario);
     virtual bool fireballCollideCheck(Fireball* fireball);
+    
+    // Savestate support. Overrides must call the base class first.
+    // Pointers to other objects (spriteTemplate, Mario's carried shell)
+    // are not written here; LevelScene stores and restores them.
+    virtual SpriteKind getKind() const { return SpriteKind::SPRITE; }
+    virtual void writeState(StateWriter& out) const;
+    virtual void readState(StateReader& in);
 };
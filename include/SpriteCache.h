@@ -0,0 +1,59 @@
+/**
+ * @file SpriteCache.h
+ * @brief Cache of sprite sheets converted to RGBA.
+ * @ingroup core
+ *
+ * Decoding the PNG and GIF sheets and converting paletted pixels to
+ * RGBA dominates startup on slow machines. SpriteCache keeps each
+ * converted ("cooked") image in the cache directory under the user data
+ * directory, so later starts map the file and upload the pixels as is.
+ *
+ * A cache file records the path, size and modification time of the
+ * image it was made from, plus a hash of its contents. The cache is
+ * used when path, size and time match; if only the time differs (the
+ * file was copied or touched) the hash decides. Anything else, such as
+ * a new user override, cooks the image again. Images in the resource
+ * archive are checked against the hash stored in the archive instead.
+ *
+ * Cache file layout (RGBA bytes are in memory order, so the file is the
+ * same on every platform):
+ *   u32 magic ("TXCK"), u32 version, u64 source size, i64 source mtime,
+ *   u64 source hash, i32 width, i32 height, u32 path length,
+ *   u32 reserved, path, padding to 8 bytes, u8 rgba[width * height * 4]
+ */
+#pragma once
+#include "Common.h"
+#include "MappedFile.h"
+#include "ResourceArchive.h"
+
+/// An image as RGBA32 with its transparency applied
+struct CookedImage {
+    int width = 0;
+    int height = 0;
+    const uint8_t* pixels = nullptr;  ///< width * 4 bytes per row
+    
+    std::vector<uint8_t> storage;     ///< Holds the pixels after cooking...
+    MappedFile mapped;                ///< ...or after loading from the cache
+};
+
+class SpriteCache {
+public:
+    // Directory for cache files, ending in a slash ("" to cook in
+    // memory only). It must exist.
+    static void setDirectory(const std::string& directory);
+    
+    // Load the image at `sourcePath` from the cache, or decode and cook
+    // it (and store the result). False if the image cannot be decoded.
+    static bool load(const std::string& sourcePath, CookedImage& out);
+    // Same for an entry of the resource archive at `archivePath`
+    static bool load(const std::string& archivePath, const ResourceArchive& archive,
+                     const ResourceArchive::Entry& entry, CookedImage& out);
+    // Decode an image held in memory (embedded resources). The cache is
+    // not used, so nothing touches the disk.
+    static bool load(const std::string& name, const uint8_t* data, size_t size, CookedImage& out);
+    
+    // Convert a decoded image. An alpha channel is kept; otherwise
+    // paletted images are transparent at their colour key and other
+    // images where they are magenta (255, 0, 255).
+    static bool cook(SDL_Surface* source, std::vector<uint8_t>& pixels);
+};
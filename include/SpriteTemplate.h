@@ -18,6 +18,7 @@ public:
     bool winged;
     bool isDead = false;
     int lastVisibleTick = -1;
+    uint32_t cell = 0;  ///< Index into Level::spriteTemplates
     Sprite* sprite = nullptr;
     
     SpriteTemplate(int type, bool winged);
@@ -0,0 +1,107 @@
+/**
+ * @file TileTables.h
+ * @brief Built-in tile behaviors and the lookup tables derived from them.
+ * @ingroup level
+ *
+ * The default behavior of each of the 256 tiles (the contents of
+ * resources/tiles.dat) is compiled in, and the tables that collision,
+ * spawning and rendering look up are computed from it at compile time.
+ * Level::TILE_BEHAVIORS and Level::TILE_TABLES start out as these
+ * defaults; Level::loadBehaviors() replaces both when the player has
+ * their own tiles.dat.
+ */
+#pragma once
+#include "Common.h"
+#include "Level.h"
+
+struct TileTables {
+    /// Bits of `solidity`: which moves a tile stops
+    static constexpr uint8_t SOLID_FALLING = 1 << 0;  ///< Moving down (ya > 0)
+    static constexpr uint8_t SOLID_RISING = 1 << 1;   ///< Moving up (ya < 0)
+    static constexpr uint8_t SOLID_SIDEWAYS = 1 << 2; ///< Moving sideways only
+    
+    /// How an animated tile picks its frame
+    enum Animation : uint8_t {
+        STILL,  ///< One frame
+        CYCLE,  ///< Four frames in turn
+        BLINK   ///< Question blocks: first frame, with a short flash now and then
+    };
+    
+    std::array<uint8_t, 256> solidity{};
+    std::array<uint8_t, 256> animation{};
+    /// Sprite sheet column of the tile (of its first frame if animated)
+    std::array<uint8_t, 256> sheetColumn{};
+    /// Cannons fire bullet bills while they are near the screen
+    std::array<bool, 256> cannon{};
+    
+    static constexpr TileTables derive(const std::array<uint8_t, 256>& behaviors) {
+        TileTables tables;
+        for (int b = 0; b < 256; b++) {
+            uint8_t behavior = behaviors[b];
+            uint8_t solidity = 0;
+            if (behavior & (Level::BIT_BLOCK_ALL | Level::BIT_BLOCK_UPPER)) solidity |= SOLID_FALLING;
+            if (behavior & (Level::BIT_BLOCK_ALL | Level::BIT_BLOCK_LOWER)) solidity |= SOLID_RISING;
+            if (behavior & Level::BIT_BLOCK_ALL) solidity |= SOLID_SIDEWAYS;
+            tables.solidity[b] = solidity;
+            
+            int column = b % 16;
+            int row = b / 16;
+            tables.animation[b] = STILL;
+            tables.sheetColumn[b] = (uint8_t)column;
+            if (behavior & Level::BIT_ANIMATED) {
+                // Frames are the four columns of the tile's group
+                tables.sheetColumn[b] = (uint8_t)(column / 4 * 4);
+                if (column / 4 == 0 && row == 1) {
+                    tables.animation[b] = BLINK;
+                } else if (column / 4 == 3 && row == 0) {
+                    // Cannons show their third frame only
+                    tables.sheetColumn[b] += 2;
+                    tables.cannon[b] = true;
+                } else {
+                    tables.animation[b] = CYCLE;
+                }
+            }
+        }
+        return tables;
+    }
+    
+    // Sheet column of tile b at render tick `tick`, for a tile at (x, y)
+    int frameColumn(int b, int tick, int x, int y) const {
+        switch (animation[b]) {
+        case CYCLE:
+            return sheetColumn[b] + (tick / 3) % 4;
+        case BLINK: {
+            int frame = (tick / 2 + (x + y) / 8) % 20;
+            return sheetColumn[b] + (frame > 3 ? 0 : frame);
+        }
+        default:
+            return sheetColumn[b];
+        }
+    }
+};
+
+/// resources/tiles.dat, row by row of the tile sheet
+inline constexpr std::array<uint8_t, 256> DEFAULT_TILE_BEHAVIORS = {
+    0x00, 0x14, 0x1c, 0x00, 0x82, 0x82, 0x82, 0x82, 0x02, 0x02, 0x02, 0x02, 0x02, 0x00, 0x8a, 0x00,
+    0xa2, 0x92, 0x9a, 0xa2, 0x92, 0x92, 0x9a, 0x92, 0x02, 0x00, 0x02, 0x02, 0x02, 0x00, 0x02, 0x00,
+    0xc0, 0xc0, 0xc0, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x02, 0x02, 0x02, 0x00, 0x01, 0x01, 0x01, 0x00, 0x02, 0x02, 0x02, 0x00, 0x02, 0x02, 0x02, 0x00,
+    0x02, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x02, 0x00, 0x02, 0x02, 0x02, 0x00,
+    0x02, 0x02, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x02, 0x00, 0x02, 0x02, 0x02, 0x00,
+    0x02, 0x02, 0x02, 0x00, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+inline constexpr TileTables DEFAULT_TILE_TABLES = TileTables::derive(DEFAULT_TILE_BEHAVIORS);
+
+static_assert(DEFAULT_TILE_TABLES.cannon[14], "Tile 14 is the cannon top");
+static_assert(DEFAULT_TILE_TABLES.solidity[4 + 8 * 16] == TileTables::SOLID_FALLING,
+              "Platform tops can only be landed on");
@@ -7,6 +7,7 @@
  */
 #pragma once
 #include "Scene.h"
+#include "Art.h"
 #include <string>
 
 class BgRenderer;
@@ -25,6 +26,8 @@ private:
     bool wasDown = true;
     BgRenderer* bgLayer0 = nullptr;
     BgRenderer* bgLayer1 = nullptr;
+    AssetHandle logo{ASSET_LOGO};
+    AssetHandle titleScreen{ASSET_TITLE_SCREEN};
     
     // Menu
     int selectedOption = 0;
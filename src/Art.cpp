@@ -4,18 +4,35 @@
  * 
  * Resources are loaded with the following priority:
  * 1. User data directory (~/.local/share/infinitetux/ on Linux)
- * 2. System resource directory (/usr/share/games/infinitetux/resources/)
+ * 2. Resource archive (resources/resources.pak), if installed
+ * 3. System resource directory (/usr/share/games/infinitetux/resources/),
+ *    or the resources compiled into the executable (EmbeddedResources.h)
  * 
  * This allows users to override any resource by placing a file with the
- * same name in their user data directory.
+ * same name in their user data directory. Both trees are listed once at
+ * startup (see ResourceIndex), so lookups do not touch the disk.
  */
 #include "Art.h"
 #include "InputConfig.h"
+#include "SpriteCache.h"
+#include "ResourceIndex.h"
+#include "ResourceArchive.h"
+#include "EmbeddedResources.h"
+#include "MusicCache.h"
 #include <iostream>
 #include <fstream>
 #include <array>
 #include <sys/stat.h>
 #include <cerrno>
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -50,10 +67,12 @@ SDL_Renderer* Art::renderer = nullptr;
 std::string Art::resourcePath;
 std::string Art::userDataDir;
 
+static ResourceArchive archive;
+static std::string archivePath;
+
 // Check if a file exists
 bool Art::fileExists(const std::string& path) {
-    std::ifstream f(path);
-    return f.good();
+    return ResourceIndex::exists(path);
 }
 
 // Get the user data directory following XDG Base Directory Specification
@@ -95,8 +114,7 @@ std::string Art::getUserDataDir() {
 }
 
 // Resolve a resource path - check user directory first, then system
-std::string Art::resolveResource(const std::string& relativePath) {
-    // First, check user data directory
+std::string Art::findUserOverride(const std::string& relativePath) {
     if (!userDataDir.empty()) {
         std::string userPath = userDataDir + relativePath;
         if (fileExists(userPath)) {
@@ -104,13 +122,109 @@ std::string Art::resolveResource(const std::string& relativePath) {
             return userPath;
         }
     }
+    return "";
+}
+
+std::string Art::resolveResource(const std::string& relativePath) {
+    // First, check user data directory
+    std::string userPath = findUserOverride(relativePath);
+    if (!userPath.empty()) return userPath;
     
     // Fall back to system resource path
     return resourcePath + relativePath;
 }
 
-// Forward declaration
+SDL_RWops* Art::openResource(const std::string& relativePath) {
+    std::string path = findUserOverride(relativePath);
+    if (path.empty()) {
+        if (archive.isOpen()) {
+            if (const ResourceArchive::Entry* entry = archive.find(relativePath)) {
+                return archive.openRW(*entry);
+            }
+        }
+        if (const EmbeddedResource* embedded = EmbeddedResources::find(relativePath)) {
+            return SDL_RWFromConstMem(embedded->data, (int)embedded->size);
+        }
+        if (EmbeddedResources::available()) return nullptr;  // There is no resource directory
+        path = resourcePath + relativePath;
+    }
+    return ResourceIndex::exists(path) ? SDL_RWFromFile(path.c_str(), "rb") : nullptr;
+}
+
+bool Art::readResource(const std::string& relativePath, std::string& out) {
+    SDL_RWops* rw = openResource(relativePath);
+    if (!rw) return false;
+    Sint64 size = SDL_RWsize(rw);
+    out.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= 0 && SDL_RWread(rw, &out[0], 1, out.size()) == out.size();
+    SDL_RWclose(rw);
+    return ok;
+}
+
+// Decode (or fetch from the sprite cache) an image, from wherever
+// openResource() would read it
+static bool loadCookedImage(const std::string& relativePath, CookedImage& out) {
+    std::string path = Art::findUserOverride(relativePath);
+    if (path.empty()) {
+        if (archive.isOpen()) {
+            if (const ResourceArchive::Entry* entry = archive.find(relativePath)) {
+                return SpriteCache::load(archivePath, archive, *entry, out);
+            }
+        }
+        if (const EmbeddedResource* embedded = EmbeddedResources::find(relativePath)) {
+            return SpriteCache::load(relativePath, embedded->data, embedded->size, out);
+        }
+        path = Art::resourcePath + relativePath;
+    }
+    return SpriteCache::load(path, out);
+}
+
+// Forward declarations
 static void createUserDataStructure(const std::string& userDir);
+static void startAudio();
+static void stopAudio();
+
+// Audio runs on a thread of its own (see startAudio): it opens the
+// device and loads the sounds, then carries out music commands, so
+// loading a track never holds up a frame. Sound effects are played from
+// the main thread by flushSounds() once updateAudio() has seen the
+// device come up; until then they stay queued.
+static std::thread audioThread;
+static std::atomic<bool> audioLoaded(false);  // Set by the audio thread
+static bool audioReady = false;               // Main thread only
+
+// Mixer channels for sound effects
+static const int SOUND_VOICES = 32;
+
+// Which sound wins a voice when there are not enough; indexed by
+// SampleIndex
+static const uint8_t SOUND_PRIORITY[SAMPLE_COUNT] = {
+    2,  // SAMPLE_BREAK_BLOCK
+    3,  // SAMPLE_GET_COIN
+    2,  // SAMPLE_MARIO_JUMP
+    2,  // SAMPLE_MARIO_STOMP
+    2,  // SAMPLE_MARIO_KICK
+    5,  // SAMPLE_MARIO_POWER_UP
+    5,  // SAMPLE_MARIO_POWER_DOWN
+    6,  // SAMPLE_MARIO_DEATH
+    2,  // SAMPLE_ITEM_SPROUT
+    1,  // SAMPLE_CANNON_FIRE
+    1,  // SAMPLE_SHELL_BUMP
+    6,  // SAMPLE_LEVEL_EXIT
+    5,  // SAMPLE_MARIO_1UP
+    2,  // SAMPLE_MARIO_FIREBALL
+    4,  // SAMPLE_LOW_TIME
+};
+
+/// What a mixer channel was last given
+struct Voice {
+    int sample = -1;     ///< -1 once it has finished
+    uint32_t batch = 0;  ///< flushSounds() call that started it
+};
+
+static std::bitset<SAMPLE_COUNT> queuedSounds;  ///< Asked for since the last flush
+static std::array<Voice, SOUND_VOICES> voices;
+static uint32_t soundBatch = 0;
 
 bool Art::init(SDL_Renderer* rend, const std::string& resPath) {
     renderer = rend;
@@ -123,42 +237,28 @@ bool Art::init(SDL_Renderer* rend, const std::string& resPath) {
     
     // Create user data directory structure with README (for custom resources)
     createUserDataStructure(userDataDir);
+    SpriteCache::setDirectory(userDataDir.empty() ? "" : userDataDir + "cache/");
+    MusicCache::setDirectory(userDataDir.empty() ? "" : userDataDir + "cache/");
+    
+    // List both trees once; lookups are answered from memory after this.
+    // Embedded resources replace the resource directory.
+    if (!userDataDir.empty()) ResourceIndex::preload(userDataDir);
+    if (EmbeddedResources::available()) {
+        DEBUG_PRINT("Using the resources built into the executable");
+    } else {
+        ResourceIndex::preload(resourcePath);
+        archivePath = resourcePath + ResourceArchive::FILE_NAME;
+        if (ResourceIndex::exists(archivePath) && archive.open(archivePath)) {
+            DEBUG_PRINT("Using resource archive %s (%zu files)", archivePath.c_str(), archive.size());
+        }
+    }
+    ResourceIndex::watch();
+    
+    // The audio device and sounds come up alongside the images
+    startAudio();
     
     try {
-        // Load sprite sheets (with user override support)
-        mario = cutImage(resolveResource("mariosheet.png"), 32, 32);
-        smallMario = cutImage(resolveResource("smallmariosheet.png"), 16, 16);
-        fireMario = cutImage(resolveResource("firemariosheet.png"), 32, 32);
-        enemies = cutImage(resolveResource("enemysheet.png"), 16, 32);
-        items = cutImage(resolveResource("itemsheet.png"), 16, 16);
-        level = cutImage(resolveResource("mapsheet.png"), 16, 16);
-        map = cutImage(resolveResource("worldmap.png"), 16, 16);
-        particles = cutImage(resolveResource("particlesheet.png"), 8, 8);
-        bg = cutImage(resolveResource("bgsheet.png"), 32, 32);
-        font = cutImage(resolveResource("font.gif"), 8, 8);
-        endScene = cutImage(resolveResource("endscene.gif"), 96, 96);
-        gameOver = cutImage(resolveResource("gameovergost.gif"), 96, 64);
-        
-        // Load single images
-        logo = loadTexture(resolveResource("logo.gif"));
-        titleScreen = loadTexture(resolveResource("title.gif"));
-        
-        // Load sounds
-        samples[SAMPLE_BREAK_BLOCK] = Mix_LoadWAV(resolveResource("snd/breakblock.wav").c_str());
-        samples[SAMPLE_GET_COIN] = Mix_LoadWAV(resolveResource("snd/coin.wav").c_str());
-        samples[SAMPLE_MARIO_JUMP] = Mix_LoadWAV(resolveResource("snd/jump.wav").c_str());
-        samples[SAMPLE_MARIO_STOMP] = Mix_LoadWAV(resolveResource("snd/stomp.wav").c_str());
-        samples[SAMPLE_MARIO_KICK] = Mix_LoadWAV(resolveResource("snd/kick.wav").c_str());
-        samples[SAMPLE_MARIO_POWER_UP] = Mix_LoadWAV(resolveResource("snd/powerup.wav").c_str());
-        samples[SAMPLE_MARIO_POWER_DOWN] = Mix_LoadWAV(resolveResource("snd/powerdown.wav").c_str());
-        samples[SAMPLE_MARIO_DEATH] = Mix_LoadWAV(resolveResource("snd/death.wav").c_str());
-        samples[SAMPLE_ITEM_SPROUT] = Mix_LoadWAV(resolveResource("snd/sprout.wav").c_str());
-        samples[SAMPLE_CANNON_FIRE] = Mix_LoadWAV(resolveResource("snd/cannon.wav").c_str());
-        samples[SAMPLE_SHELL_BUMP] = Mix_LoadWAV(resolveResource("snd/bump.wav").c_str());
-        samples[SAMPLE_LEVEL_EXIT] = Mix_LoadWAV(resolveResource("snd/exit.wav").c_str());
-        samples[SAMPLE_MARIO_1UP] = Mix_LoadWAV(resolveResource("snd/1-up.wav").c_str());
-        samples[SAMPLE_MARIO_FIREBALL] = Mix_LoadWAV(resolveResource("snd/fireball.wav").c_str());
-        samples[SAMPLE_LOW_TIME] = Mix_LoadWAV(resolveResource("snd/lowtime.wav").c_str());
+        loadAssets();
         
         // Note: Music is loaded on-demand in startMusic() to support soundfont switching
         // Music files are also resolved through resolveResource() there
@@ -171,6 +271,163 @@ bool Art::init(SDL_Renderer* rend, const std::string& resPath) {
     return true;
 }
 
+/// An image file and where its textures go
+struct ImageFile {
+    const char* name;
+    int xSize, ySize;                                 ///< Cell size (sheets only)
+    std::vector<std::vector<SDL_Texture*>>* sheet;    ///< Cut into cells...
+    SDL_Texture** single;                             ///< ...or kept whole
+};
+
+struct SoundFile {
+    int index;
+    const char* name;
+};
+
+/// One image on its way in: decoded by a worker, uploaded by init()
+struct AssetJob {
+    const ImageFile* image = nullptr;
+    CookedImage pixels;
+    bool decoded = false;
+    double decodeMillis = 0;
+};
+
+// Loaded by the audio thread (see startAudio)
+static const SoundFile SOUND_FILES[] = {
+    {SAMPLE_BREAK_BLOCK, "snd/breakblock.wav"},
+    {SAMPLE_GET_COIN, "snd/coin.wav"},
+    {SAMPLE_MARIO_JUMP, "snd/jump.wav"},
+    {SAMPLE_MARIO_STOMP, "snd/stomp.wav"},
+    {SAMPLE_MARIO_KICK, "snd/kick.wav"},
+    {SAMPLE_MARIO_POWER_UP, "snd/powerup.wav"},
+    {SAMPLE_MARIO_POWER_DOWN, "snd/powerdown.wav"},
+    {SAMPLE_MARIO_DEATH, "snd/death.wav"},
+    {SAMPLE_ITEM_SPROUT, "snd/sprout.wav"},
+    {SAMPLE_CANNON_FIRE, "snd/cannon.wav"},
+    {SAMPLE_SHELL_BUMP, "snd/bump.wav"},
+    {SAMPLE_LEVEL_EXIT, "snd/exit.wav"},
+    {SAMPLE_MARIO_1UP, "snd/1-up.wav"},
+    {SAMPLE_MARIO_FIREBALL, "snd/fireball.wav"},
+    {SAMPLE_LOW_TIME, "snd/lowtime.wav"},
+};
+
+// Indexed by SceneAsset
+static const ImageFile SCENE_ASSETS[SCENE_ASSET_COUNT] = {
+    {"worldmap.png", 16, 16, &Art::map, nullptr},
+    {"endscene.gif", 96, 96, &Art::endScene, nullptr},
+    {"gameovergost.gif", 96, 64, &Art::gameOver, nullptr},
+    {"logo.gif", 0, 0, nullptr, &Art::logo},
+    {"title.gif", 0, 0, nullptr, &Art::titleScreen},
+};
+static int sceneAssetRefs[SCENE_ASSET_COUNT] = {};
+
+// Run job(0) .. job(count - 1) on one worker per core, this thread included
+static void runJobs(size_t count, const std::function<void(size_t)>& job) {
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            job(i);
+        }
+    };
+    int threads = (int)std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+static double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Art::acquire(SceneAsset asset) {
+    if (sceneAssetRefs[asset]++ > 0) return;
+    
+    const ImageFile& file = SCENE_ASSETS[asset];
+    auto start = std::chrono::steady_clock::now();
+    CookedImage image;
+    if (!loadCookedImage(file.name, image)) return;
+    if (file.sheet) {
+        *file.sheet = cutImage(image, file.xSize, file.ySize);
+    } else {
+        *file.single = createTexture(image, 0, 0, image.width, image.height);
+    }
+    DEBUG_PRINT("Loaded %s for a scene in %.2f ms", file.name, millisSince(start));
+}
+
+void Art::release(SceneAsset asset) {
+    if (sceneAssetRefs[asset] <= 0 || --sceneAssetRefs[asset] > 0) return;
+    
+    const ImageFile& file = SCENE_ASSETS[asset];
+    if (file.sheet) {
+        freeSheet(*file.sheet);
+    } else if (*file.single) {
+        SDL_DestroyTexture(*file.single);
+        *file.single = nullptr;
+    }
+    DEBUG_PRINT("Freed %s", file.name);
+}
+
+void Art::freeSheet(std::vector<std::vector<SDL_Texture*>>& sheet) {
+    for (auto& row : sheet) {
+        for (auto* tex : row) {
+            if (tex) SDL_DestroyTexture(tex);
+        }
+    }
+    sheet.clear();
+}
+
+void Art::loadAssets() {
+    const ImageFile images[] = {
+        {"mariosheet.png", 32, 32, &mario, nullptr},
+        {"smallmariosheet.png", 16, 16, &smallMario, nullptr},
+        {"firemariosheet.png", 32, 32, &fireMario, nullptr},
+        {"enemysheet.png", 16, 32, &enemies, nullptr},
+        {"itemsheet.png", 16, 16, &items, nullptr},
+        {"mapsheet.png", 16, 16, &level, nullptr},
+        {"particlesheet.png", 8, 8, &particles, nullptr},
+        {"bgsheet.png", 32, 32, &bg, nullptr},
+        {"font.gif", 8, 8, &font, nullptr},
+    };
+    std::vector<AssetJob> jobs(std::size(images));
+    for (size_t i = 0; i < jobs.size(); i++) {
+        jobs[i].image = &images[i];
+    }
+    
+    // Decode phase: image decoding and RGBA conversion on every core
+    auto start = std::chrono::steady_clock::now();
+    runJobs(jobs.size(), [&jobs](size_t i) {
+        AssetJob& job = jobs[i];
+        auto jobStart = std::chrono::steady_clock::now();
+        job.decoded = loadCookedImage(job.image->name, job.pixels);
+        job.decodeMillis = millisSince(jobStart);
+    });
+    double decodeMillis = millisSince(start);
+    
+    // Upload phase: textures can only be created on the render thread
+    start = std::chrono::steady_clock::now();
+    double decodeWork = 0;
+    for (AssetJob& job : jobs) {
+        auto uploadStart = std::chrono::steady_clock::now();
+        if (job.decoded) {
+            if (job.image->sheet) {
+                *job.image->sheet = cutImage(job.pixels, job.image->xSize, job.image->ySize);
+            } else {
+                *job.image->single = createTexture(job.pixels, 0, 0, job.pixels.width, job.pixels.height);
+            }
+        }
+        decodeWork += job.decodeMillis;
+        DEBUG_PRINT("  %-20s decode %7.2f ms  upload %7.2f ms%s", job.image->name,
+                    job.decodeMillis, millisSince(uploadStart), job.decoded ? "" : "  (failed)");
+    }
+    DEBUG_PRINT("Loaded %zu images: decode %.2f ms (%.2f ms of work), upload %.2f ms",
+                jobs.size(), decodeMillis, decodeWork, millisSince(start));
+}
+
 // Create a directory (cross-platform)
 static bool createDirectory(const std::string& path) {
 #ifdef _WIN32
@@ -189,10 +446,12 @@ static void createUserDataStructure(const std::string& userDir) {
     createDirectory(userDir + "snd");
     createDirectory(userDir + "mus");
     createDirectory(userDir + "soundfonts");
+    createDirectory(userDir + "cache");
     
     // Create README if it doesn't exist
+    // (checked on disk: the resource index is not built yet)
     std::string readmePath = userDir + "README.txt";
-    if (!Art::fileExists(readmePath)) {
+    if (!std::ifstream(readmePath).good()) {
         std::ofstream readme(readmePath);
         if (readme.is_open()) {
             readme << "INFINITE TUX - Custom Resources Directory\n";
@@ -205,6 +464,7 @@ static void createUserDataStructure(const std::string& userDir) {
             readme << "├── snd/          - Sound effects (WAV format)\n";
             readme << "├── mus/          - Music files (MIDI format)\n";
             readme << "├── soundfonts/   - Custom soundfonts (SF2 format)\n";
+            readme << "├── cache/        - Converted sprite sheets (rebuilt as needed, safe to delete)\n";
             readme << "└── (image files) - Sprite sheets and images\n\n";
             readme << "IMAGE FILES (place in main directory):\n";
             readme << "---------------------------------------\n";
@@ -259,7 +519,15 @@ static void createUserDataStructure(const std::string& userDir) {
             readme << "- Sound files should be in WAV format (PCM recommended).\n";
             readme << "- Music files should be in MIDI format (.mid).\n";
             readme << "- Run the game with --debug to see which files are being loaded.\n";
-            readme << "- Changes take effect on next game launch (no hot-reloading).\n\n";
+#if defined(INFINITE_TUX_WATCH_RESOURCES) && defined(__linux__)
+            readme << "- Files added or removed while the game runs are noticed right away.\n";
+#else
+            readme << "- Files added or removed while the game runs are noticed on the next\n";
+            readme << "  launch.\n";
+#endif
+            readme << "- Images and sounds are loaded at startup or when a screen first needs\n";
+            readme << "  them, so a replaced file shows up after a restart or the next time\n";
+            readme << "  that screen loads it. Music is loaded each time a track starts.\n\n";
             readme << "EXAMPLE:\n";
             readme << "--------\n";
             readme << "To replace Mario's sprites, create your own 'mariosheet.png' with the\n";
@@ -272,31 +540,33 @@ static void createUserDataStructure(const std::string& userDir) {
 }
 
 void Art::cleanup() {
+    // The audio thread may still be filling in samples and music
+    stopAudio();
+    MusicCache::shutdown();
+    audioLoaded = false;
+    audioReady = false;
+    queuedSounds.reset();
+    voices.fill(Voice());
+    ResourceIndex::clear();
+    
     // Clean up sprite sheets
-    auto cleanupSheet = [](std::vector<std::vector<SDL_Texture*>>& sheet) {
-        for (auto& row : sheet) {
-            for (auto* tex : row) {
-                if (tex) SDL_DestroyTexture(tex);
-            }
-        }
-        sheet.clear();
-    };
+    freeSheet(mario);
+    freeSheet(smallMario);
+    freeSheet(fireMario);
+    freeSheet(enemies);
+    freeSheet(items);
+    freeSheet(level);
+    freeSheet(particles);
+    freeSheet(font);
+    freeSheet(bg);
     
-    cleanupSheet(mario);
-    cleanupSheet(smallMario);
-    cleanupSheet(fireMario);
-    cleanupSheet(enemies);
-    cleanupSheet(items);
-    cleanupSheet(level);
-    cleanupSheet(particles);
-    cleanupSheet(font);
-    cleanupSheet(bg);
-    cleanupSheet(map);
-    cleanupSheet(endScene);
-    cleanupSheet(gameOver);
-    
-    if (logo) { SDL_DestroyTexture(logo); logo = nullptr; }
-    if (titleScreen) { SDL_DestroyTexture(titleScreen); titleScreen = nullptr; }
+    // Scene assets still held (normally none once the scenes are gone)
+    for (int asset = 0; asset < SCENE_ASSET_COUNT; asset++) {
+        if (sceneAssetRefs[asset] > 0) {
+            sceneAssetRefs[asset] = 1;
+            release((SceneAsset)asset);
+        }
+    }
     
     // Clean up sounds
     for (auto& sample : samples) {
@@ -307,147 +577,36 @@ void Art::cleanup() {
     for (auto& mus : music) {
         if (mus) { Mix_FreeMusic(mus); mus = nullptr; }
     }
+    
+    // Last: music streams from the archive while it plays
+    archive.close();
 }
 
-SDL_Surface* Art::loadImage(const std::string& path) {
-    SDL_Surface* surface = IMG_Load(path.c_str());
-    if (!surface) {
-        std::cerr << "Failed to load image " << path << ": " << IMG_GetError() << std::endl;
-    }
-    return surface;
-}
-
-SDL_Texture* Art::loadTexture(const std::string& path) {
-    SDL_Surface* surface = loadImage(path);
-    if (!surface) return nullptr;
-    
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
-    
+SDL_Texture* Art::createTexture(const CookedImage& image, int x, int y, int w, int h) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, w, h);
     if (!texture) {
-        std::cerr << "Failed to create texture from " << path << ": " << SDL_GetError() << std::endl;
+        std::cerr << "Failed to create texture: " << SDL_GetError() << std::endl;
+        return nullptr;
     }
-    
+    const uint8_t* pixels = image.pixels + ((size_t)y * image.width + x) * 4;
+    SDL_UpdateTexture(texture, nullptr, pixels, image.width * 4);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
     return texture;
 }
 
-std::vector<std::vector<SDL_Texture*>> Art::cutImage(const std::string& path, int xSize, int ySize) {
-    SDL_Surface* source = loadImage(path);
-    if (!source) {
-        DEBUG_PRINT("Art::cutImage FAILED to load: %s", path.c_str());
-        return {};
-    }
-    
-    int xCount = source->w / xSize;
-    int yCount = source->h / ySize;
-    
-    DEBUG_PRINT("Art::cutImage loaded %s: %dx%d pixels -> %dx%d tiles (%dx%d each)", 
-                path.c_str(), source->w, source->h, xCount, yCount, xSize, ySize);
+std::vector<std::vector<SDL_Texture*>> Art::cutImage(const CookedImage& sheet, int xSize, int ySize) {
+    int xCount = sheet.width / xSize;
+    int yCount = sheet.height / ySize;
     
+    // The sheet is already RGBA with transparency applied, so each cell
+    // is uploaded straight from it
     std::vector<std::vector<SDL_Texture*>> images(xCount);
-    
-    // Check if source has alpha channel
-    bool hasAlpha = (source->format->Amask != 0);
-    
-    // Check if source has color key (GIF transparency)
-    Uint32 sourceColorKey;
-    bool hasColorKey = (SDL_GetColorKey(source, &sourceColorKey) == 0);
-    
     for (int x = 0; x < xCount; x++) {
         images[x].resize(yCount);
         for (int y = 0; y < yCount; y++) {
-            SDL_Surface* tileSurface = nullptr;
-            
-            if (hasAlpha) {
-                // Source has alpha channel - create RGBA surface and blit directly
-                tileSurface = SDL_CreateRGBSurfaceWithFormat(
-                    0, xSize, ySize, 32, SDL_PIXELFORMAT_RGBA32);
-                
-                if (tileSurface) {
-                    // Clear to fully transparent
-                    SDL_FillRect(tileSurface, nullptr, SDL_MapRGBA(tileSurface->format, 0, 0, 0, 0));
-                    
-                    // Enable blending on source for proper alpha copy
-                    SDL_SetSurfaceBlendMode(source, SDL_BLENDMODE_NONE);
-                    
-                    SDL_Rect srcRect = {x * xSize, y * ySize, xSize, ySize};
-                    SDL_BlitSurface(source, &srcRect, tileSurface, nullptr);
-                }
-            } else if (hasColorKey || source->format->BytesPerPixel == 1) {
-                // Paletted image with color key - handle manually
-                tileSurface = SDL_CreateRGBSurfaceWithFormat(
-                    0, xSize, ySize, 32, SDL_PIXELFORMAT_RGBA32);
-                
-                if (tileSurface) {
-                    SDL_FillRect(tileSurface, nullptr, SDL_MapRGBA(tileSurface->format, 0, 0, 0, 0));
-                    
-                    SDL_LockSurface(source);
-                    SDL_LockSurface(tileSurface);
-                    
-                    for (int py = 0; py < ySize; py++) {
-                        for (int px = 0; px < xSize; px++) {
-                            int srcX = x * xSize + px;
-                            int srcY = y * ySize + py;
-                            
-                            Uint8 r, g, b, a = 255;
-                            
-                            if (source->format->BytesPerPixel == 1) {
-                                // Paletted
-                                Uint8* srcPixel = (Uint8*)source->pixels + srcY * source->pitch + srcX;
-                                Uint8 index = *srcPixel;
-                                SDL_GetRGB(index, source->format, &r, &g, &b);
-                                
-                                // Check transparency by palette index
-                                if (hasColorKey && index == (sourceColorKey & 0xFF)) {
-                                    a = 0;
-                                }
-                            } else {
-                                // Get pixel value
-                                Uint8* srcPixel = (Uint8*)source->pixels + srcY * source->pitch + srcX * source->format->BytesPerPixel;
-                                Uint32 pixel;
-                                memcpy(&pixel, srcPixel, source->format->BytesPerPixel);
-                                SDL_GetRGB(pixel, source->format, &r, &g, &b);
-                                
-                                // Check for magenta transparency
-                                if (r == 255 && g == 0 && b == 255) {
-                                    a = 0;
-                                }
-                            }
-                            
-                            Uint32* dstPixel = (Uint32*)((Uint8*)tileSurface->pixels + py * tileSurface->pitch) + px;
-                            *dstPixel = SDL_MapRGBA(tileSurface->format, r, g, b, a);
-                        }
-                    }
-                    
-                    SDL_UnlockSurface(tileSurface);
-                    SDL_UnlockSurface(source);
-                }
-            } else {
-                // No alpha, no color key - use magenta as transparency
-                tileSurface = SDL_CreateRGBSurfaceWithFormat(
-                    0, xSize, ySize, 32, SDL_PIXELFORMAT_RGBA32);
-                
-                if (tileSurface) {
-                    SDL_Rect srcRect = {x * xSize, y * ySize, xSize, ySize};
-                    SDL_BlitSurface(source, &srcRect, tileSurface, nullptr);
-                    
-                    // Set magenta as color key
-                    Uint32 colorKey = SDL_MapRGB(tileSurface->format, 255, 0, 255);
-                    SDL_SetColorKey(tileSurface, SDL_TRUE, colorKey);
-                }
-            }
-            
-            if (tileSurface) {
-                images[x][y] = SDL_CreateTextureFromSurface(renderer, tileSurface);
-                if (images[x][y]) {
-                    SDL_SetTextureBlendMode(images[x][y], SDL_BLENDMODE_BLEND);
-                }
-                SDL_FreeSurface(tileSurface);
-            }
+            images[x][y] = createTexture(sheet, x * xSize, y * ySize, xSize, ySize);
         }
     }
-    
-    SDL_FreeSurface(source);
     return images;
 }
 
@@ -455,10 +614,58 @@ std::vector<std::vector<SDL_Texture*>> Art::cutImage(const std::string& path, in
 static int sfxVolume = 64;  // Default to 50% to balance with quieter music
 
 void Art::playSound(int sampleIndex) {
-    if (sampleIndex >= 0 && sampleIndex < SAMPLE_COUNT && samples[sampleIndex]) {
-        int channel = Mix_PlayChannel(-1, samples[sampleIndex], 0);
-        if (channel >= 0) {
-            Mix_Volume(channel, sfxVolume);
+    // The same sound twice in a tick plays once
+    if (sampleIndex >= 0 && sampleIndex < SAMPLE_COUNT) {
+        queuedSounds.set(sampleIndex);
+    }
+}
+
+// Channel for a sound of `priority`: a free one, else the voice playing
+// the least important sound (the oldest of those, then the lowest
+// channel) if that is no more important than this one. -1 if every
+// voice is busy with something that matters more.
+static int pickVoice(int priority) {
+    int victim = -1;
+    for (int channel = 0; channel < SOUND_VOICES; channel++) {
+        const Voice& voice = voices[channel];
+        if (voice.sample < 0) return channel;
+        if (voice.batch == soundBatch) continue;  // Started in this batch
+        if (victim < 0 || SOUND_PRIORITY[voice.sample] < SOUND_PRIORITY[voices[victim].sample] ||
+            (SOUND_PRIORITY[voice.sample] == SOUND_PRIORITY[voices[victim].sample] &&
+             voice.batch < voices[victim].batch)) {
+            victim = channel;
+        }
+    }
+    if (victim >= 0 && SOUND_PRIORITY[voices[victim].sample] <= priority) return victim;
+    return -1;
+}
+
+void Art::flushSounds() {
+    if (!audioReady || queuedSounds.none()) return;
+    soundBatch++;
+    
+    // Forget voices that have finished
+    for (int channel = 0; channel < SOUND_VOICES; channel++) {
+        if (voices[channel].sample >= 0 && !Mix_Playing(channel)) {
+            voices[channel].sample = -1;
+        }
+    }
+    
+    // Most important first (ties in SampleIndex order)
+    std::array<int, SAMPLE_COUNT> batch;
+    int count = 0;
+    for (int sample = 0; sample < SAMPLE_COUNT; sample++) {
+        if (queuedSounds[sample] && samples[sample]) batch[count++] = sample;
+    }
+    queuedSounds.reset();
+    std::stable_sort(batch.begin(), batch.begin() + count,
+                     [](int a, int b) { return SOUND_PRIORITY[a] > SOUND_PRIORITY[b]; });
+    
+    for (int i = 0; i < count; i++) {
+        int channel = pickVoice(SOUND_PRIORITY[batch[i]]);
+        if (channel < 0) continue;
+        if (Mix_PlayChannel(channel, samples[batch[i]], 0) >= 0) {
+            voices[channel] = Voice{batch[i], soundBatch};
         }
     }
 }
@@ -470,7 +677,10 @@ void Art::initVolumeFromConfig() {
     // Load saved volume settings from InputConfig
     musicVolume = INPUTCFG.getMusicVolume();
     sfxVolume = INPUTCFG.getSfxVolume();
-    Mix_VolumeMusic(musicVolume);
+    if (audioReady) {
+        Mix_VolumeMusic(musicVolume);
+        Mix_Volume(-1, sfxVolume);
+    }
     DEBUG_PRINT("Loaded volumes - Music: %d%%, SFX: %d%%", 
                 (musicVolume * 100 / MIX_MAX_VOLUME), 
                 (sfxVolume * 100 / MIX_MAX_VOLUME));
@@ -484,175 +694,344 @@ static std::string buildSoundfontPath(const std::string& soundfont) {
     return InputConfig::getSoundfontPath() + soundfont;
 }
 
-// Apply soundfont for a specific track
-static void applySoundfontForTrack(int musicIndex) {
-    std::string soundfont = INPUTCFG.getSoundfontForTrack(musicIndex);
-    
-    if (soundfont.empty()) {
-        // No custom soundfont - use system defaults
-#ifdef _WIN32
-        Mix_SetSoundFonts("C:\\soundfonts\\FluidR3_GM.sf2");
-#else
-        Mix_SetSoundFonts("/usr/share/sounds/sf2/FluidR3_GM.sf2");
-#endif
-    } else {
+// File FluidSynth should load for a track's soundfont setting (from
+// InputConfig::getSoundfontForTrack)
+static std::string soundfontPath(const std::string& soundfont) {
+    if (!soundfont.empty()) {
         // Use custom soundfont from resources/soundfonts/
         std::string fullPath = buildSoundfontPath(soundfont);
         
         // Check if file exists before trying to use it
-        std::ifstream testFile(fullPath);
-        if (testFile.good()) {
-            testFile.close();
-            Mix_SetSoundFonts(fullPath.c_str());
-        } else {
-            std::cerr << "[AUDIO] Soundfont not found: " << fullPath << ", using system default" << std::endl;
+        if (ResourceIndex::exists(fullPath)) {
+            return fullPath;
+        }
+        std::cerr << "[AUDIO] Soundfont not found: " << fullPath << ", using system default" << std::endl;
+    }
+    // No custom soundfont - use system defaults
 #ifdef _WIN32
-            Mix_SetSoundFonts("C:\\soundfonts\\FluidR3_GM.sf2");
+    return "C:\\soundfonts\\FluidR3_GM.sf2";
 #else
-            Mix_SetSoundFonts("/usr/share/sounds/sf2/FluidR3_GM.sf2");
+    return "/usr/share/sounds/sf2/FluidR3_GM.sf2";
 #endif
-        }
-    }
 }
 
-// Get music file path for track index (with user override support)
+// Apply a track's soundfont setting
+static void applySoundfont(const std::string& soundfont) {
+    Mix_SetSoundFonts(soundfontPath(soundfont).c_str());
+}
+
+// Music file for a track index (opened through Art::openResource)
 static std::string getMusicPath(int musicIndex) {
     switch (musicIndex) {
-        case MUSIC_MAP: return Art::resolveResource("mus/smb3map1.mid");
-        case MUSIC_OVERWORLD: return Art::resolveResource("mus/smwovr1.mid");
-        case MUSIC_UNDERGROUND: return Art::resolveResource("mus/smb3undr.mid");
-        case MUSIC_CASTLE: return Art::resolveResource("mus/smwfortress.mid");
-        case MUSIC_TITLE: return Art::resolveResource("mus/smwtitle.mid");
+        case MUSIC_MAP: return "mus/smb3map1.mid";
+        case MUSIC_OVERWORLD: return "mus/smwovr1.mid";
+        case MUSIC_UNDERGROUND: return "mus/smb3undr.mid";
+        case MUSIC_CASTLE: return "mus/smwfortress.mid";
+        case MUSIC_TITLE: return "mus/smwtitle.mid";
         default: return "";
     }
 }
 
-// Flag to prevent rapid music restarts which can crash FluidSynth
-static bool musicLoadInProgress = false;
+/// A request for the audio thread. Settings only the main thread may
+/// read (InputConfig, volume, synth) are copied in.
+struct MusicCommand {
+    enum Type { PLAY, STOP, PRELOAD, PAUSE, RESUME, SET_SYNTH };
+    
+    Type type;
+    int track = -1;
+    bool restart = false;
+    std::string soundfont;  ///< InputConfig::getSoundfontForTrack(track)
+    int synth = 0;
+    int volume = MIX_MAX_VOLUME;
+};
+
+static std::mutex musicMutex;
+static std::condition_variable musicWake;
+static std::deque<MusicCommand> musicCommands;
+static bool musicStopping = false;
 
-// Track which soundfont is currently loaded for each track
+// MIDI synth setting (main thread)
+static int midiSynthType = 0;  // 0=default, 1=native, 2=timidity
+
+// What each loaded track was loaded with (audio thread)
 static std::array<std::string, MUSIC_COUNT> currentSoundfonts = {};
+static std::array<int, MUSIC_COUNT> loadedSynths = {};
+// Rendered file (see MusicCache) each loaded track was read from, or ""
+// where the MIDI file was loaded
+static std::array<std::string, MUSIC_COUNT> renderedPaths = {};
 
-void Art::startMusic(int musicIndex, bool forceRestart) {
-    DEBUG_PRINT("startMusic(%d, forceRestart=%d) called", musicIndex, forceRestart);
-    
-    // Prevent rapid restarts
-    if (musicLoadInProgress) {
-        DEBUG_PRINT("Music load in progress, skipping");
-        return;
-    }
-    
-    // Validate index first
-    if (musicIndex < 0 || musicIndex >= MUSIC_COUNT) {
-        currentMusic = -1;
-        DEBUG_PRINT("Invalid music index");
-        return;
-    }
-    
-    musicLoadInProgress = true;
-    
-    // Check if soundfont has changed
-    DEBUG_PRINT("Getting soundfont for track...");
-    std::string newSoundfont = INPUTCFG.getSoundfontForTrack(musicIndex);
-    bool soundfontChanged = (currentSoundfonts[musicIndex] != newSoundfont);
-    DEBUG_PRINT("Soundfont: '%s', changed=%d", newSoundfont.c_str(), soundfontChanged);
-    
-    // If music exists, soundfont hasn't changed, AND we're not forcing a restart, just play it
-    // When forceRestart is true, we must reload to ensure music starts from the beginning
-    // (Mix_RewindMusic doesn't reliably reset MIDI position after Mix_HaltMusic)
-    if (music[musicIndex] && !soundfontChanged && !forceRestart) {
-        DEBUG_PRINT("Playing cached music...");
-        
-        // Stop any currently playing music
-        if (Mix_PlayingMusic()) {
-            Mix_HaltMusic();
-        }
-        
-        // Rewind to beginning if it's a different track
-        if (currentMusic != musicIndex) {
-            Mix_RewindMusic();
+// The rendered copy of a track for its soundfont and synth, or "" (and
+// rendering it in the background if it is missing). Native MIDI does
+// not go through FluidSynth, so it is never rendered.
+static std::string findRenderedMusic(int musicIndex, const std::string& soundfont, int synth) {
+    if (!MusicCache::available() || synth == 1) return "";
+    std::string midi;
+    if (!Art::readResource(getMusicPath(musicIndex), midi)) return "";
+    return MusicCache::find(midi, soundfontPath(soundfont), synth);
+}
+
+// Queue a command for the audio thread. Queued commands it makes
+// pointless are dropped, so a burst of restarts loads the track once:
+// play and stop replace any waiting play, stop, pause or resume. A play
+// that replaces a waiting play of the same track keeps its restart.
+static void queueMusic(MusicCommand command) {
+    std::lock_guard<std::mutex> lock(musicMutex);
+    if (command.type == MusicCommand::PLAY) {
+        for (const MusicCommand& queued : musicCommands) {
+            if (queued.type == MusicCommand::PLAY && queued.track == command.track) {
+                command.restart = command.restart || queued.restart;
+            }
         }
-        
-        Mix_VolumeMusic(musicVolume);
-        if (Mix_PlayMusic(music[musicIndex], -1) == -1) {
-            std::cerr << "[AUDIO] Failed to play music: " << Mix_GetError() << std::endl;
-            currentMusic = -1;
-        } else {
-            currentMusic = musicIndex;
+    }
+    auto superseded = [&command](const MusicCommand& queued) {
+        switch (command.type) {
+            case MusicCommand::PLAY:
+            case MusicCommand::STOP:
+                return queued.type != MusicCommand::PRELOAD && queued.type != MusicCommand::SET_SYNTH;
+            case MusicCommand::PAUSE:
+            case MusicCommand::RESUME:
+                return queued.type == MusicCommand::PAUSE || queued.type == MusicCommand::RESUME;
+            case MusicCommand::PRELOAD:
+                return queued.type == MusicCommand::PRELOAD && queued.track == command.track;
+            case MusicCommand::SET_SYNTH:
+                return queued.type == MusicCommand::SET_SYNTH;
         }
-        musicLoadInProgress = false;
-        DEBUG_PRINT("Cached music playing");
+        return false;
+    };
+    musicCommands.erase(std::remove_if(musicCommands.begin(), musicCommands.end(), superseded),
+                        musicCommands.end());
+    musicCommands.push_back(command);
+    musicWake.notify_one();
+}
+
+// Make Art::music[track] hold the track as the command wants it, loading
+// it again only if needed. Audio thread.
+static void prepareMusic(const MusicCommand& command) {
+    int track = command.track;
+    std::string rendered = findRenderedMusic(track, command.soundfont, command.synth);
+    bool current = Art::music[track] && currentSoundfonts[track] == command.soundfont &&
+                   loadedSynths[track] == command.synth && renderedPaths[track] == rendered;
+    // A restart must reload a MIDI track to start from the beginning
+    // (Mix_RewindMusic doesn't reliably reset MIDI position after
+    // Mix_HaltMusic). Rendered tracks restart when played, so they are kept.
+    if (current && (!command.restart || !rendered.empty())) {
+        DEBUG_PRINT("Music %d already loaded", track);
         return;
     }
     
-    DEBUG_PRINT("Need to load music...");
-    
-    // Stop any currently playing music
-    if (Mix_PlayingMusic()) {
-        DEBUG_PRINT("Halting current music...");
-        Mix_HaltMusic();
+    // Free old music if it exists (this halts it if it is playing)
+    if (Art::music[track]) {
+        Mix_FreeMusic(Art::music[track]);
+        Art::music[track] = nullptr;
     }
     
-    // Free old music if it exists
-    if (music[musicIndex]) {
-        DEBUG_PRINT("Freeing old music...");
-        Mix_FreeMusic(music[musicIndex]);
-        music[musicIndex] = nullptr;
+    auto start = std::chrono::steady_clock::now();
+    currentSoundfonts[track] = command.soundfont;
+    loadedSynths[track] = command.synth;
+    renderedPaths[track] = "";
+    if (!rendered.empty()) {
+        Art::music[track] = Mix_LoadMUS(rendered.c_str());
+        if (Art::music[track]) renderedPaths[track] = rendered;
+    }
+    if (!Art::music[track]) {
+        // Apply soundfont for this track (must be done before loading)
+        applySoundfont(command.soundfont);
+        SDL_RWops* musicData = Art::openResource(getMusicPath(track));
+        Art::music[track] = musicData ? Mix_LoadMUS_RW(musicData, 1) : nullptr;
+    }
+    if (Art::music[track]) {
+        DEBUG_PRINT("Loaded music %d in %.2f ms%s", track, millisSince(start), rendered.empty() ? "" : " (rendered)");
+    } else {
+        std::cerr << "[AUDIO] Failed to load music: " << getMusicPath(track) << " - " << Mix_GetError() << std::endl;
+    }
+}
+
+static void setMidiSynth(int synth) {
+    const char* synthName;
+    switch (synth) {
+        case 0:
+            synthName = "Default (SDL_mixer auto)";
+            // Clear any custom settings, use SDL_mixer default
+            Mix_SetSoundFonts(NULL);
+            break;
+        case 1:
+            synthName = "Native MIDI";
+            // Try to use native MIDI (Windows/macOS have built-in synths)
+            // This hint tells SDL_mixer to prefer native MIDI
+            SDL_SetHint("SDL_NATIVE_MUSIC", "1");
+            Mix_SetSoundFonts(NULL);
+            break;
+        case 2:
+            synthName = "FluidSynth (if available)";
+            // FluidSynth typically sounds better but needs a soundfont
+            SDL_SetHint("SDL_NATIVE_MUSIC", "0");
+            // Set soundfont path - FluidSynth will use the first one it finds
+            // Note: FluidSynth may print errors for paths that don't exist, this is normal
+#ifdef _WIN32
+            Mix_SetSoundFonts("C:\\soundfonts\\FluidR3_GM.sf2");
+#else
+            // Most common location on Debian/Ubuntu systems
+            Mix_SetSoundFonts("/usr/share/sounds/sf2/FluidR3_GM.sf2");
+#endif
+            break;
+        default:
+            synthName = "Default";
+            break;
     }
     
-    // Apply soundfont for this track (must be done before loading)
-    DEBUG_PRINT("Applying soundfont...");
-    applySoundfontForTrack(musicIndex);
-    currentSoundfonts[musicIndex] = newSoundfont;  // Remember the soundfont
-    
-    std::string musicPath = getMusicPath(musicIndex);
-    DEBUG_PRINT("Music path: %s", musicPath.c_str());
+    DEBUG_PRINT("MIDI Synth: %s", synthName);
+}
+
+// Carry out one command. Audio thread.
+static void runMusicCommand(const MusicCommand& command) {
+    switch (command.type) {
+        case MusicCommand::PLAY:
+            // Stop any currently playing music
+            if (Mix_PlayingMusic()) {
+                Mix_HaltMusic();
+            }
+            prepareMusic(command);
+            if (!Art::music[command.track]) break;
+            
+            // Set music volume before playing to prevent distortion
+            Mix_VolumeMusic(command.volume);
+            if (Mix_PlayMusic(Art::music[command.track], -1) == -1) {
+                std::cerr << "[AUDIO] Failed to play music: " << Mix_GetError() << std::endl;
+                Mix_FreeMusic(Art::music[command.track]);
+                Art::music[command.track] = nullptr;
+                renderedPaths[command.track] = "";
+            }
+            break;
+        case MusicCommand::STOP:
+            if (Mix_PlayingMusic()) {
+                Mix_HaltMusic();
+            }
+            break;
+        case MusicCommand::PRELOAD:
+            prepareMusic(command);
+            break;
+        case MusicCommand::PAUSE:
+            Mix_PauseMusic();
+            break;
+        case MusicCommand::RESUME:
+            Mix_ResumeMusic();
+            break;
+        case MusicCommand::SET_SYNTH:
+            setMidiSynth(command.synth);
+            break;
+    }
+}
+
+static MusicCommand musicCommand(MusicCommand::Type type, int track = -1) {
+    MusicCommand command;
+    command.type = type;
+    command.track = track;
+    if (track >= 0) command.soundfont = INPUTCFG.getSoundfontForTrack(track);
+    command.synth = midiSynthType;
+    command.volume = musicVolume;
+    return command;
+}
+
+void Art::startMusic(int musicIndex, bool forceRestart) {
+    DEBUG_PRINT("startMusic(%d, forceRestart=%d) called", musicIndex, forceRestart);
     
-    if (musicPath.empty()) {
+    // Validate index first
+    if (musicIndex < 0 || musicIndex >= MUSIC_COUNT) {
         currentMusic = -1;
-        musicLoadInProgress = false;
-        DEBUG_PRINT("Empty music path, aborting");
+        DEBUG_PRINT("Invalid music index");
         return;
     }
     
-    // Load the music file
-    DEBUG_PRINT("Calling Mix_LoadMUS()...");
-    music[musicIndex] = Mix_LoadMUS(musicPath.c_str());
-    DEBUG_PRINT("Mix_LoadMUS returned: %s", (music[musicIndex] ? "success" : "null"));
-    
-    if (music[musicIndex]) {
-        // Set music volume before playing to prevent distortion
-        Mix_VolumeMusic(musicVolume);
-        
-        // Play the music
-        if (Mix_PlayMusic(music[musicIndex], -1) == -1) {
-            std::cerr << "[AUDIO] Failed to play music: " << Mix_GetError() << std::endl;
-            Mix_FreeMusic(music[musicIndex]);
-            music[musicIndex] = nullptr;
-            currentMusic = -1;
+    MusicCommand command = musicCommand(MusicCommand::PLAY, musicIndex);
+    command.restart = forceRestart;
+    queueMusic(command);
+    currentMusic = musicIndex;
+}
+
+void Art::preloadMusic(int musicIndex) {
+    if (musicIndex < 0 || musicIndex >= MUSIC_COUNT) return;
+    queueMusic(musicCommand(MusicCommand::PRELOAD, musicIndex));
+}
+
+void Art::stopMusic() {
+    queueMusic(musicCommand(MusicCommand::STOP));
+    currentMusic = -1;
+}
+
+void Art::pauseMusic(bool paused) {
+    queueMusic(musicCommand(paused ? MusicCommand::PAUSE : MusicCommand::RESUME));
+}
+
+// Open the audio device and load the sound effects on a thread of its
+// own (Mix_OpenAudio alone can take a good part of a second), then run
+// music commands on it until stopAudio(). The title track is preloaded,
+// which also loads its soundfont.
+static void startAudio() {
+    queueMusic(musicCommand(MusicCommand::PRELOAD, MUSIC_TITLE));
+    audioThread = std::thread([]() {
+        auto start = std::chrono::steady_clock::now();
+        if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+            std::cerr << "SDL_mixer initialization failed: " << Mix_GetError() << std::endl;
+            // Continue without sound
         } else {
-            currentMusic = musicIndex;
+            Mix_AllocateChannels(SOUND_VOICES);
+            double openMillis = millisSince(start);
+            for (const SoundFile& sound : SOUND_FILES) {
+                auto soundStart = std::chrono::steady_clock::now();
+                SDL_RWops* rw = Art::openResource(sound.name);
+                Art::samples[sound.index] = rw ? Mix_LoadWAV_RW(rw, 1) : nullptr;
+                DEBUG_PRINT("  %-20s load %7.2f ms%s", sound.name, millisSince(soundStart),
+                            Art::samples[sound.index] ? "" : "  (failed)");
+            }
+            DEBUG_PRINT("Audio ready in %.2f ms: device %.2f ms, %zu sounds %.2f ms", millisSince(start),
+                        openMillis, std::size(SOUND_FILES), millisSince(start) - openMillis);
         }
-    } else {
-        std::cerr << "[AUDIO] Failed to load music: " << musicPath << " - " << Mix_GetError() << std::endl;
-        currentMusic = -1;
+        audioLoaded = true;
+        
+        std::unique_lock<std::mutex> lock(musicMutex);
+        while (true) {
+            musicWake.wait(lock, [] { return musicStopping || !musicCommands.empty(); });
+            if (musicStopping) return;
+            MusicCommand command = std::move(musicCommands.front());
+            musicCommands.pop_front();
+            lock.unlock();
+            runMusicCommand(command);
+            lock.lock();
+        }
+    });
+}
+
+// Drop waiting commands and end the audio thread (after the command it
+// is running, if any)
+static void stopAudio() {
+    {
+        std::lock_guard<std::mutex> lock(musicMutex);
+        musicStopping = true;
+        musicCommands.clear();
     }
-    
-    musicLoadInProgress = false;
+    musicWake.notify_one();
+    if (audioThread.joinable()) audioThread.join();
+    musicStopping = false;
 }
 
-void Art::stopMusic() {
-    if (Mix_PlayingMusic()) {
-        Mix_HaltMusic();
+void Art::updateAudio() {
+    if (audioReady || !audioLoaded) return;
+    audioReady = true;
+    
+    Mix_VolumeMusic(musicVolume);
+    Mix_Volume(-1, sfxVolume);
+    
+    // Queue renders of the tracks that have none yet
+    for (int track = 0; track < MUSIC_COUNT; track++) {
+        findRenderedMusic(track, INPUTCFG.getSoundfontForTrack(track), midiSynthType);
     }
-    currentMusic = -1;
 }
 
 void Art::adjustMusicVolume(int delta) {
     musicVolume += delta;
     if (musicVolume < 0) musicVolume = 0;
     if (musicVolume > MIX_MAX_VOLUME) musicVolume = MIX_MAX_VOLUME;
-    Mix_VolumeMusic(musicVolume);
+    if (audioReady) Mix_VolumeMusic(musicVolume);
     
     // Save to config for persistence
     INPUTCFG.setMusicVolume(musicVolume);
@@ -669,6 +1048,7 @@ void Art::adjustSfxVolume(int delta) {
     sfxVolume += delta;
     if (sfxVolume < 0) sfxVolume = 0;
     if (sfxVolume > MIX_MAX_VOLUME) sfxVolume = MIX_MAX_VOLUME;
+    if (audioReady) Mix_Volume(-1, sfxVolume);
     
     // Save to config for persistence
     INPUTCFG.setSfxVolume(sfxVolume);
@@ -681,45 +1061,9 @@ int Art::getSfxVolume() {
     return sfxVolume;
 }
 
-// Static variable to track current MIDI synth setting
-static int midiSynthType = 0;  // 0=default, 1=native, 2=timidity
-
 void Art::cycleMidiSynth() {
     midiSynthType = (midiSynthType + 1) % 3;
-    
-    const char* synthName;
-    switch (midiSynthType) {
-        case 0:
-            synthName = "Default (SDL_mixer auto)";
-            // Clear any custom settings, use SDL_mixer default
-            Mix_SetSoundFonts(NULL);
-            break;
-        case 1:
-            synthName = "Native MIDI";
-            // Try to use native MIDI (Windows/macOS have built-in synths)
-            // This hint tells SDL_mixer to prefer native MIDI
-            SDL_SetHint("SDL_NATIVE_MUSIC", "1");
-            Mix_SetSoundFonts(NULL);
-            break;
-        case 2:
-            synthName = "FluidSynth (if available)";
-            // FluidSynth typically sounds better but needs a soundfont
-            SDL_SetHint("SDL_NATIVE_MUSIC", "0");
-            // Set soundfont path - FluidSynth will use the first one it finds
-            // Note: FluidSynth may print errors for paths that don't exist, this is normal
-#ifdef _WIN32
-            Mix_SetSoundFonts("C:\\soundfonts\\FluidR3_GM.sf2");
-#else
-            // Most common location on Debian/Ubuntu systems
-            Mix_SetSoundFonts("/usr/share/sounds/sf2/FluidR3_GM.sf2");
-#endif
-            break;
-        default:
-            synthName = "Default";
-            break;
-    }
-    
-    DEBUG_PRINT("MIDI Synth: %s", synthName);
+    queueMusic(musicCommand(MusicCommand::SET_SYNTH));
     
     // Reload and restart current music with new synth
     if (currentMusic >= 0 && currentMusic < MUSIC_COUNT) {
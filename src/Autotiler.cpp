@@ -0,0 +1,128 @@
+/**
+ * @file Autotiler.cpp
+ * @brief Ground autotiling.
+ */
+#include "Autotiler.h"
+#include "Level.h"
+#include "LevelGenerator.h"
+#include <algorithm>
+
+static const uint8_t PLAIN_GROUND = 1 + 9 * 16;  // What generators place
+
+// Tile for each corner mask (bit 0 top-left, 1 top-right, 2 bottom-left,
+// 3 bottom-right corner inside ground), before the level type offset.
+// A ground tile with no corner inside ground stands alone and goes
+// back to plain ground.
+static const uint8_t TILE_FOR_CORNERS[16] = {
+    PLAIN_GROUND,   // None (no type offset)
+    2 + 10 * 16,    // Top-left only: bottom-right outer corner
+    0 + 10 * 16,    // Top-right only: bottom-left outer corner
+    1 + 10 * 16,    // Top: bottom edge
+    2 + 8 * 16,     // Bottom-left only: top-right outer corner
+    2 + 9 * 16,     // Left: right edge
+    1 + 9 * 16,     // Diagonal
+    3 + 10 * 16,    // All but bottom-right: inner corner
+    0 + 8 * 16,     // Bottom-right only: top-left outer corner
+    1 + 9 * 16,     // Diagonal
+    0 + 9 * 16,     // Right: left edge
+    3 + 11 * 16,    // All but bottom-left: inner corner
+    1 + 8 * 16,     // Bottom: top edge
+    3 + 9 * 16,     // All but top-right: inner corner
+    3 + 8 * 16,     // All but top-left: inner corner
+    1 + 9 * 16,     // All: fill
+};
+
+// Rows 8-11 of the sheet, columns 0-3 plus the castle (8) or
+// underground (12) offset. Hills use columns 4-6 of the same rows.
+bool Autotiler::isGround(uint8_t tile) {
+    int column = tile % 16;
+    int row = tile / 16;
+    return row >= 8 && row <= 11 && (column < 4 || column >= 8);
+}
+
+static int groundOffset(int type) {
+    if (type == LevelGenerator::TYPE_CASTLE) return 8;
+    if (type == LevelGenerator::TYPE_UNDERGROUND) return 12;
+    return 0;
+}
+
+// Ground rows of column x as bits, with x clamped into the level (or
+// wrapped, for levels that store their columns in a ring)
+static uint64_t groundMask(const Level* level, int x) {
+    const uint8_t* column = &level->map[(size_t)level->columnIndex(x) * level->height];
+    uint64_t mask = 0;
+    for (int y = 0; y < level->height; y++) {
+        if (Autotiler::isGround(column[y])) mask |= 1ull << y;
+    }
+    return mask;
+}
+
+// Bit y set when the tile corner at the top of row y touches ground in
+// rows y-1 and y; rows outside the level repeat the edge rows
+static uint64_t rowPairs(uint64_t ground, int height) {
+    uint64_t below = ground | (((ground >> (height - 1)) & 1) << height);
+    uint64_t above = (ground << 1) | (ground & 1);
+    return below & above;
+}
+
+static uint8_t tileFor(int corners, int to) {
+    return corners == 0 ? PLAIN_GROUND : (uint8_t)(TILE_FOR_CORNERS[corners] + to);
+}
+
+// Slow path for levels too tall for a 64-bit column
+static int cornersAt(const Level* level, int cx, int cy) {
+    for (int x = cx - 1; x <= cx; x++) {
+        for (int y = cy - 1; y <= cy; y++) {
+            if (!Autotiler::isGround(level->getBlockCapped(x, y))) return 0;
+        }
+    }
+    return 1;
+}
+
+void Autotiler::apply(Level* level, int type, int x0, int x1) {
+    const int height = level->height;
+    const int to = groundOffset(type);
+    // Tile x depends on columns x-1 .. x+1
+    x0 = std::max(x0 - 1, level->firstColumn);
+    x1 = std::min(x1 + 1, level->endColumn);
+    if (x0 >= x1 || height <= 0) return;
+    
+    if (height >= 64) {
+        for (int x = x0; x < x1; x++) {
+            for (int y = 0; y < height; y++) {
+                if (!isGround(level->getBlock(x, y))) continue;
+                int corners = cornersAt(level, x, y) | cornersAt(level, x + 1, y) << 1 |
+                              cornersAt(level, x, y + 1) << 2 | cornersAt(level, x + 1, y + 1) << 3;
+                uint8_t tile = tileFor(corners, to);
+                if (level->getBlock(x, y) != tile) level->setBlock(x, y, tile);
+            }
+        }
+        return;
+    }
+    
+    // Corner columns x and x+1 (bit y: top corner of row y, bits 0..height)
+    uint64_t ground = groundMask(level, x0);
+    uint64_t pairsHere = rowPairs(ground, height);
+    uint64_t left = rowPairs(groundMask(level, x0 - 1), height) & pairsHere;
+    
+    for (int x = x0; x < x1; x++) {
+        uint64_t groundRight = groundMask(level, x + 1);
+        uint64_t pairsRight = rowPairs(groundRight, height);
+        uint64_t right = pairsHere & pairsRight;
+        
+        // A corner inside ground implies the tile is ground, so only
+        // ground tiles can change
+        const uint8_t* column = &level->map[(size_t)level->columnIndex(x) * height];
+        for (int y = 0; ground >> y; y++) {
+            if (!((ground >> y) & 1)) continue;
+            int corners = (int)((left >> y) & 1) | (int)((right >> y) & 1) << 1 |
+                          (int)((left >> (y + 1)) & 1) << 2 | (int)((right >> (y + 1)) & 1) << 3;
+            uint8_t tile = tileFor(corners, to);
+            if (column[y] != tile) level->setBlock(x, y, tile);
+        }
+        
+        ground = groundRight;
+        pairsHere = pairsRight;
+        left = right;
+    }
+}
@@ -5,8 +5,8 @@
  * with parallax scrolling based on camera position. Different level
  * types (overground, underground, castle) have different visual styles.
  * 
- * The background level is generated once at construction and is large
- * enough to handle extended scrolling (2048+ tiles wide).
+ * The background level is generated once at construction (2048 tiles
+ * wide) and repeats, so it covers levels of any width.
  */
 
 #include "BgRenderer.h"
@@ -18,9 +18,14 @@ BgRenderer::BgRenderer(int width, int height, int levelType, int distance, bool
     : width(width), height(height), levelType(levelType), distance(distance) {
     // Generate a large background level (2048 tiles like Java)
     // This ensures we don't run out of level during long scrolling
-    int bgWidth = 2048;
     int bgHeight = 15;
-    bgLevel = generateBgLevel(bgWidth, bgHeight, distant, levelType);
+    bgLevel = generateBgLevel(BG_WIDTH, bgHeight, distant, levelType);
+    bgLevel->wrapColumns = true;
+}
+
+BgRenderer::BgRenderer(int width, int height, int levelType, int distance, Level* bgLevel)
+    : width(width), height(height), levelType(levelType), distance(distance), bgLevel(bgLevel) {
+    if (bgLevel) bgLevel->wrapColumns = true;
 }
 
 BgRenderer::~BgRenderer() {
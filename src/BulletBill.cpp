@@ -4,6 +4,7 @@
  */
 // BulletBill.cpp
 #include "BulletBill.h"
+#include "SaveState.h"
 #include "LevelScene.h"
 #include "Mario.h"
 #include "Art.h"
@@ -97,3 +98,17 @@ bool BulletBill::fireballCollideCheck(Fireball* fireball) {
     // Bullet Bills are immune to fireballs - can only be stomped
     return false;
 }
+
+void BulletBill::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(facing);
+    out.write<int32_t>(height);
+    out.write<int32_t>(deadTime);
+}
+
+void BulletBill::readState(StateReader& in) {
+    Sprite::readState(in);
+    facing = in.read<int32_t>();
+    height = in.read<int32_t>();
+    deadTime = in.read<int32_t>();
+}
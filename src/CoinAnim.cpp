@@ -15,10 +15,10 @@
 
 // CoinAnim.cpp
 #include "CoinAnim.h"
+#include "SaveState.h"
 #include "LevelScene.h"
 #include "Art.h"
 #include "Sparkle.h"
-#include <cstdlib>
 
 /**
  * Creates a coin animation at the specified tile position.
@@ -59,9 +59,9 @@ void CoinAnim::move() {
             // Spawn sparkles when coin disappears
             for (int xx = 0; xx < 2; xx++) {
                 for (int yy = 0; yy < 2; yy++) {
-                    spriteContext->addSprite(new Sparkle(
-                        (int)x + xx * 8 + rand() % 8,
-                        (int)y + yy * 8 + rand() % 8,
+                    spriteContext->addSprite(new Sparkle(spriteContext,
+                        (int)x + xx * 8 + spriteContext->random.nextInt(8),
+                        (int)y + yy * 8 + spriteContext->random.nextInt(8),
                         0, 0, 0, 2, 5));
                 }
             }
@@ -78,3 +78,13 @@ void CoinAnim::move() {
     y += ya;
     ya += 1;  // Gravity
 }
+
+void CoinAnim::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(life);
+}
+
+void CoinAnim::readState(StateReader& in) {
+    Sprite::readState(in);
+    life = in.read<int32_t>();
+}
@@ -0,0 +1,27 @@
+/**
+ * @file EmbeddedResources.cpp
+ * @brief Lookup in the embedded resource table.
+ */
+#include "EmbeddedResources.h"
+#include <algorithm>
+
+#ifdef INFINITE_TUX_EMBED_RESOURCES
+// Generated at build time (cmake/EmbedResources.cmake)
+#include "EmbeddedResourceData.inc"
+#else
+static const EmbeddedResource EMBEDDED_RESOURCES[1] = {{"", nullptr, 0}};
+static const size_t EMBEDDED_RESOURCE_COUNT = 0;
+#endif
+
+bool EmbeddedResources::available() {
+    return EMBEDDED_RESOURCE_COUNT > 0;
+}
+
+const EmbeddedResource* EmbeddedResources::find(std::string_view name) {
+    const EmbeddedResource* end = EMBEDDED_RESOURCES + EMBEDDED_RESOURCE_COUNT;
+    const EmbeddedResource* it = std::lower_bound(EMBEDDED_RESOURCES, end, name,
+                                                  [](const EmbeddedResource& resource, std::string_view name) {
+        return std::string_view(resource.name) < name;
+    });
+    return (it != end && it->name == name) ? it : nullptr;
+}
@@ -3,6 +3,7 @@
  * @brief Ground enemy implementation.
  */
 #include "Enemy.h"
+#include "SaveState.h"
 #include "Art.h"
 #include "LevelScene.h"
 #include "Level.h"
@@ -49,7 +50,7 @@ Enemy::Enemy(LevelScene* world, int x, int y, int dir, int type, bool winged)
         int tileX = (int)this->x / 16;
         int tileY = (int)this->y / 16;
         
-        if (tileX >= 0 && tileX < world->level->width && 
+        if (tileX >= world->level->firstColumn && tileX < world->level->endColumn && 
             tileY >= 0 && tileY < world->level->height) {
             uint8_t block = world->level->getBlock(tileX, tileY);
             if ((Level::TILE_BEHAVIORS[block] & Level::BIT_BLOCK_ALL) != 0) {
@@ -97,7 +98,7 @@ void Enemy::collideCheck() {
                 } else {
                     yPicO = 31 - (32 - 8);
                     hPic = 8;
-                    if (spriteTemplate) spriteTemplate->isDead = true;
+                    if (spriteTemplate) world->level->markTemplateDead(spriteTemplate);
                     deadTime = 10;
                     winged = false;
                     DEBUG_PRINT("Enemy %s stomped at (%.0f, %.0f)", getEnemyTypeName(type), x, y);
@@ -144,11 +145,11 @@ void Enemy::move() {
             // Death animation complete - spawn sparkles and remove enemy
             deadTime = 1;  // Prevent re-triggering
             for (int i = 0; i < 8; i++) {
-                world->addSprite(new Sparkle(
-                    (int)(x + rand() % 16 - 8) + 4,
-                    (int)(y - rand() % 8) + 4,
-                    (float)(rand() % 200) / 100.0f - 1,
-                    (float)(rand() % 100) / 100.0f * -1,
+                world->addSprite(new Sparkle(world,
+                    (int)(x + world->random.nextInt(16) - 8) + 4,
+                    (int)(y - world->random.nextInt(8)) + 4,
+                    (float)(world->random.nextInt(200)) / 100.0f - 1,
+                    (float)(world->random.nextInt(100)) / 100.0f * -1,
                     0, 1, 5));
             }
             spriteContext->removeSprite(this);
@@ -271,7 +272,7 @@ bool Enemy::shellCollideCheck(Shell* shell) {
             xa = shell->facing * 2;
             ya = -5;
             flyDeath = true;
-            if (spriteTemplate) spriteTemplate->isDead = true;
+            if (spriteTemplate) world->level->markTemplateDead(spriteTemplate);
             deadTime = 100;
             winged = false;
             yFlipPic = true;  // Flip upside down
@@ -320,7 +321,7 @@ bool Enemy::fireballCollideCheck(Fireball* fireball) {
             ya = -5;  // Initial upward velocity
             flyDeath = true;  // Enable movement during death animation
             
-            if (spriteTemplate) spriteTemplate->isDead = true;
+            if (spriteTemplate) world->level->markTemplateDead(spriteTemplate);
             deadTime = 100;  // Ticks until removal
             winged = false;  // Remove wings
             
@@ -343,7 +344,7 @@ void Enemy::bumpCheck(int xTile, int yTile) {
         xa = -world->mario->facing * 2;
         ya = -5;
         flyDeath = true;
-        if (spriteTemplate) spriteTemplate->isDead = true;
+        if (spriteTemplate) world->level->markTemplateDead(spriteTemplate);
         deadTime = 100;
         winged = false;
         yFlipPic = true;  // Flip upside down
@@ -425,3 +426,43 @@ void Enemy::render(SDL_Renderer* renderer, float alpha) {
         }
     }
 }
+
+void Enemy::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(facing);
+    out.write<int32_t>(deadTime);
+    out.write(flyDeath);
+    out.write(avoidCliffs);
+    out.write(winged);
+    out.write(noFireballDeath);
+    out.write(runTime);
+    out.write(onGround);
+    out.write(mayJump);
+    out.write<int32_t>(jumpTime);
+    out.write(xJumpSpeed);
+    out.write(yJumpSpeed);
+    out.write<int32_t>(width);
+    out.write<int32_t>(height);
+    out.write<int32_t>(type);
+    out.write<int32_t>(wingTime);
+}
+
+void Enemy::readState(StateReader& in) {
+    Sprite::readState(in);
+    facing = in.read<int32_t>();
+    deadTime = in.read<int32_t>();
+    flyDeath = in.readBool();
+    avoidCliffs = in.readBool();
+    winged = in.readBool();
+    noFireballDeath = in.readBool();
+    runTime = in.read<float>();
+    onGround = in.readBool();
+    mayJump = in.readBool();
+    jumpTime = in.read<int32_t>();
+    xJumpSpeed = in.read<float>();
+    yJumpSpeed = in.read<float>();
+    width = in.read<int32_t>();
+    height = in.read<int32_t>();
+    type = in.read<int32_t>();
+    wingTime = in.read<int32_t>();
+}
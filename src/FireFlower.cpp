@@ -4,6 +4,7 @@
  */
 // FireFlower.cpp
 #include "FireFlower.h"
+#include "SaveState.h"
 #include "LevelScene.h"
 #include "Mario.h"
 #include "Art.h"
@@ -42,3 +43,13 @@ void FireFlower::collideCheck() {
         }
     }
 }
+
+void FireFlower::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(life);
+}
+
+void FireFlower::readState(StateReader& in) {
+    Sprite::readState(in);
+    life = in.read<int32_t>();
+}
@@ -3,6 +3,7 @@
  * @brief Fireball projectile implementation.
  */
 #include "Fireball.h"
+#include "SaveState.h"
 #include "LevelScene.h"
 #include "Level.h"
 #include "Art.h"
@@ -33,11 +34,11 @@ void Fireball::move() {
     if (deadTime > 0) {
         // Spawn death sparkles
         for (int i = 0; i < 8; i++) {
-            world->addSprite(new Sparkle(
-                (int)(x + (rand() % 8) - 4) + 4,
-                (int)(y + (rand() % 8) - 4) + 2,
-                (float)(rand() % 200) / 100.0f - 1 - facing,
-                (float)(rand() % 200) / 100.0f - 1,
+            world->addSprite(new Sparkle(world,
+                (int)(x + world->random.nextInt(8) - 4) + 4,
+                (int)(y + world->random.nextInt(8) - 4) + 2,
+                (float)(world->random.nextInt(200)) / 100.0f - 1 - facing,
+                (float)(world->random.nextInt(200)) / 100.0f - 1,
                 0, 1, 5));
         }
         world->fireballsOnScreen--;
@@ -177,3 +178,25 @@ void Fireball::die() {
     ya = -5;
     deadTime = 100;
 }
+
+void Fireball::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(facing);
+    out.write<int32_t>(height);
+    out.write(dead);
+    out.write<int32_t>(width);
+    out.write<int32_t>(anim);
+    out.write(onGround);
+    out.write<int32_t>(deadTime);
+}
+
+void Fireball::readState(StateReader& in) {
+    Sprite::readState(in);
+    facing = in.read<int32_t>();
+    height = in.read<int32_t>();
+    dead = in.readBool();
+    width = in.read<int32_t>();
+    anim = in.read<int32_t>();
+    onGround = in.readBool();
+    deadTime = in.read<int32_t>();
+}
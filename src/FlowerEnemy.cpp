@@ -14,6 +14,7 @@
  */
 
 #include "FlowerEnemy.h"
+#include "SaveState.h"
 #include "LevelScene.h"
 #include "Mario.h"
 #include "Art.h"
@@ -21,7 +22,6 @@
 #include "Fireball.h"
 #include "Shell.h"
 #include "Common.h"
-#include <cstdlib>
 #include <cmath>
 
 /**
@@ -73,11 +73,11 @@ void FlowerEnemy::move() {
             deadTime = 1;
             // Spawn sparkles on death
             for (int i = 0; i < 8; i++) {
-                world->addSprite(new Sparkle(
-                    (int)(x + rand() % 16 - 8) + 4,
-                    (int)(y - rand() % 8) + 4,
-                    (float)(rand() % 200) / 100.0f - 1,
-                    (float)(rand() % 100) / 100.0f * -1,
+                world->addSprite(new Sparkle(world,
+                    (int)(x + world->random.nextInt(16) - 8) + 4,
+                    (int)(y - world->random.nextInt(8)) + 4,
+                    (float)(world->random.nextInt(200)) / 100.0f - 1,
+                    (float)(world->random.nextInt(100)) / 100.0f * -1,
                     0, 1, 5));
             }
             spriteContext->removeSprite(this);
@@ -159,3 +159,17 @@ bool FlowerEnemy::shellCollideCheck(Shell* shell) {
     // Plant is exposed - use parent's collision check for death handling
     return Enemy::shellCollideCheck(shell);
 }
+
+void FlowerEnemy::writeState(StateWriter& out) const {
+    Enemy::writeState(out);
+    out.write<int32_t>(tick);
+    out.write<int32_t>(yStart);
+    out.write<int32_t>(jumpTime);
+}
+
+void FlowerEnemy::readState(StateReader& in) {
+    Enemy::readState(in);
+    tick = in.read<int32_t>();
+    yStart = in.read<int32_t>();
+    jumpTime = in.read<int32_t>();
+}
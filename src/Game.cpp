@@ -4,6 +4,9 @@
  */
 #include "Game.h"
 #include "Art.h"
+#include "ResourceIndex.h"
+#include "ResourceArchive.h"
+#include "EmbeddedResources.h"
 #include "Scene.h"
 #include "TitleScene.h"
 #include "MapScene.h"
@@ -13,10 +16,20 @@
 #include "OptionsScene.h"
 #include "Mario.h"
 #include "Level.h"
+#include "LevelGenerator.h"
+#include "LevelStats.h"
+#include "LevelCache.h"
+#include "SeedSearch.h"
+#include "LevelValidator.h"
 #include "InputConfig.h"
+#include "SaveState.h"
+#include "Enemy.h"
+#include "Autotiler.h"
 #include <iostream>
 #include <cstdio>
 #include <fstream>
+#include <sstream>
+#include <chrono>
 
 #ifndef INFINITE_TUX_DATADIR
 #define INFINITE_TUX_DATADIR ""
@@ -24,13 +37,16 @@
 
 // Helper function to check if a directory exists and contains resources
 static bool checkResourcePath(const std::string& path) {
-    std::string testFile = path + "mariosheet.png";
-    std::ifstream f(testFile);
-    return f.good();
+    return ResourceIndex::exists(path + "mariosheet.png") || ResourceIndex::exists(path + ResourceArchive::FILE_NAME);
 }
 
-// Find the resources directory - try multiple locations
+// Find the resources directory - try multiple locations. Builds with
+// embedded resources have none and return "".
 static std::string findResourcePath() {
+    if (EmbeddedResources::available()) {
+        return "";
+    }
+    
     // 1. Try compile-time DATADIR (for system installations)
     std::string systemPath = std::string(INFINITE_TUX_DATADIR) + "resources/";
     if (checkResourcePath(systemPath)) {
@@ -62,6 +78,398 @@ static std::string findResourcePath() {
 
 Game::Game() {}
 
+// Zone odds from zones.cfg, unless --zones already loaded them
+static bool loadZoneOdds() {
+    if (LevelGenerator::zoneConfigLoaded()) return true;
+    std::string text;
+    if (!Art::readResource("zones.cfg", text)) {
+        std::cerr << "Failed to open zone config: " << Art::resourcePath << "zones.cfg" << std::endl;
+        return false;
+    }
+    std::istringstream in(text);
+    return LevelGenerator::loadZoneConfig(in, Art::resourcePath + "zones.cfg");
+}
+
+// Tool modes run without SDL and only need the tile behaviors and the
+// zone odds
+static bool loadToolResources() {
+    // Tile behaviors are built in (see TileTables.h). Art is not set up,
+    // so resources come from the resource directory (or the embedded
+    // copies) without user overrides.
+    Art::resourcePath = findResourcePath();
+    return loadZoneOdds();
+}
+
+int Game::validateLevels(int64_t firstSeed, int64_t count, int difficulty) {
+    if (!loadToolResources()) return 1;
+    
+    static const char* typeNames[] = {"overground", "underground", "castle"};
+    int64_t failures = 0;
+    int64_t levels = 0;
+    double totalMicros = 0;
+    for (int64_t i = 0; i < count; i++) {
+        // Seeds wrap past INT64_MAX like MapScene::levelSeedAt
+        int64_t seed = (int64_t)((uint64_t)firstSeed + (uint64_t)i);
+        for (int type = 0; type < 3; type++) {
+            Level* level = LevelGenerator::createLevel(LevelScene::LEVEL_WIDTH, LevelScene::LEVEL_HEIGHT,
+                                                       seed, difficulty, type);
+            auto start = std::chrono::steady_clock::now();
+            ValidationResult result = LevelValidator::validate(level);
+            totalMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            
+            if (!result.reachable) {
+                printf("seed %lld %s: exit at x=%d unreachable, stuck at (%d, %d)\n",
+                       (long long)seed, typeNames[type], level->xExit, result.stuckX, result.stuckY);
+                failures++;
+            }
+            delete level;
+            levels++;
+        }
+    }
+    
+    printf("%lld of %lld levels unreachable (difficulty %d), %.1f us per level\n",
+           (long long)failures, (long long)levels, difficulty, levels > 0 ? totalMicros / levels : 0.0);
+    return failures > 0 ? 2 : 0;
+}
+
+int Game::writeLevelStats(int64_t firstSeed, int64_t count, int difficulty) {
+    if (!loadToolResources()) return 1;
+    LevelStats::collect(firstSeed, count, difficulty, 0, stdout);
+    return 0;
+}
+
+int Game::findSeeds(int64_t firstSeed, int64_t count, int difficulty, int type,
+                    const std::vector<std::string>& conditions) {
+    SeedSearch search;
+    search.difficulty = difficulty;
+    search.type = type;
+    std::vector<SeedCondition> parsed;
+    for (const std::string& text : conditions) {
+        SeedCondition condition;
+        if (!SeedCondition::parse(text, condition)) {
+            std::cerr << "Invalid condition '" << text << "'. Fields:";
+            for (int i = 0; i < LevelStats::fieldCount(); i++) {
+                std::cerr << " " << LevelStats::fieldName(i);
+            }
+            std::cerr << std::endl;
+            return 1;
+        }
+        parsed.push_back(condition);
+    }
+    search.setConditions(parsed);
+    if (!loadToolResources()) return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t scanned = 0;
+    std::vector<int64_t> seeds = search.run(firstSeed, count, &scanned);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Matches are few, so regenerate them in full for the report
+    LevelStats::writeCsvHeader(stdout);
+    Level level(LevelScene::LEVEL_WIDTH, LevelScene::LEVEL_HEIGHT);
+    for (int64_t seed : seeds) {
+        LevelGenerator::generateInto(&level, seed, difficulty, type);
+        LevelStats stats = LevelStats::measure(&level);
+        stats.seed = seed;
+        stats.type = type;
+        stats.difficulty = difficulty;
+        stats.writeCsv(stdout);
+    }
+    fflush(stdout);
+
+    fprintf(stderr, "%zu of %lld seeds matched in %.2f s (%.0f seeds per minute)\n",
+            seeds.size(), (long long)scanned, seconds, seconds > 0 ? scanned * 60.0 / seconds : 0.0);
+    return seeds.empty() ? 2 : 0;
+}
+
+// Seeds for the golden hash corpus: values that do not fit in 32 bits,
+// the extremes of int64_t, and level seeds derived from large world
+// seeds on the map, where the derivation overflows
+static std::vector<int64_t> corpusSeeds() {
+    std::vector<int64_t> seeds = {
+        0, 1, -1, 42, 2147483647LL, 2147483648LL, -2147483649LL, 4294967303LL,
+        0x123456789abcdefLL, INT64_MAX, INT64_MIN,
+    };
+    Random worlds(20240601);
+    for (int world = 0; world < 4; world++) {
+        int64_t worldSeed = worlds.nextLong();
+        for (int i = 0; i < 4; i++) {
+            seeds.push_back(MapScene::levelSeedAt(worldSeed, 3 + i * 6, 2 + i * 2));
+        }
+    }
+    return seeds;
+}
+
+int Game::writeLevelHashes() {
+    if (!loadToolResources()) return 1;
+    printf("# seed difficulty type hash (Level::contentHash of a %dx%d level)\n",
+           LevelScene::LEVEL_WIDTH, LevelScene::LEVEL_HEIGHT);
+    Level level(LevelScene::LEVEL_WIDTH, LevelScene::LEVEL_HEIGHT);
+    for (int64_t seed : corpusSeeds()) {
+        for (int difficulty : {1, 4, 8}) {
+            for (int type = 0; type < 3; type++) {
+                LevelGenerator::generateInto(&level, seed, difficulty, type);
+                printf("%lld %d %d %016llx\n", (long long)seed, difficulty, type,
+                       (unsigned long long)level.contentHash());
+            }
+        }
+    }
+    return 0;
+}
+
+int Game::checkLevelHashes(const std::string& path) {
+    if (!loadToolResources()) return 1;
+    std::string file = path.empty() ? Art::resourcePath + "level-hashes.txt" : path;
+    std::string text;
+    bool found = false;
+    if (path.empty()) {
+        found = Art::readResource("level-hashes.txt", text);
+    } else {
+        std::ifstream corpus(path);
+        std::stringstream contents;
+        contents << corpus.rdbuf();
+        found = corpus.is_open();
+        text = contents.str();
+    }
+    if (!found) {
+        std::cerr << "Failed to open level hash corpus: " << file << std::endl;
+        return 1;
+    }
+    
+    Level level(LevelScene::LEVEL_WIDTH, LevelScene::LEVEL_HEIGHT);
+    int checked = 0;
+    int mismatches = 0;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        long long seed;
+        int difficulty, type;
+        unsigned long long expected;
+        if (line[0] == '#' || sscanf(line.c_str(), "%lld %d %d %llx", &seed, &difficulty, &type, &expected) != 4) continue;
+        LevelGenerator::generateInto(&level, seed, difficulty, type);
+        uint64_t actual = level.contentHash();
+        if (actual != expected) {
+            printf("seed %lld difficulty %d type %d: hash %016llx, expected %016llx\n",
+                   seed, difficulty, type, (unsigned long long)actual, expected);
+            mismatches++;
+        }
+        checked++;
+    }
+    
+    printf("%d of %d levels differ from %s\n", mismatches, checked, file.c_str());
+    return (mismatches > 0 || checked == 0) ? 2 : 0;
+}
+
+int Game::writeLevelPack(const std::string& path, int64_t firstSeed, int count, int difficulty, int width) {
+    if (!loadToolResources()) return 1;
+    static const int BATCH = 256;
+    if (width <= 0) width = LevelScene::LEVEL_WIDTH;
+    
+    LevelPackWriter writer;
+    if (!writer.open(path)) return 1;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Level*> levels;
+    for (int i = 0; i < BATCH; i++) {
+        levels.push_back(new Level(width, LevelScene::LEVEL_HEIGHT));
+    }
+    bool ok = true;
+    for (int64_t batchStart = firstSeed; ok && batchStart < firstSeed + count; batchStart += BATCH) {
+        int seeds = (int)std::min<int64_t>(BATCH, firstSeed + count - batchStart);
+        std::vector<int64_t> batch(seeds);
+        for (int i = 0; i < seeds; i++) batch[i] = batchStart + i;
+        for (int type = 0; ok && type < 3; type++) {
+            LevelGenerator::generateBatch(batch, difficulty, type,
+                                          std::vector<Level*>(levels.begin(), levels.begin() + seeds));
+            for (int i = 0; ok && i < seeds; i++) {
+                ok = writer.add({batch[i], difficulty, type}, levels[i]);
+            }
+        }
+    }
+    for (Level* level : levels) delete level;
+    if (!writer.finish() || !ok) {
+        std::cerr << "Failed to write level pack: " << path << std::endl;
+        return 1;
+    }
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Wrote %d levels (%dx%d) to %s in %.2f s\n", count * 3, width, LevelScene::LEVEL_HEIGHT,
+           path.c_str(), seconds);
+    return 0;
+}
+
+int Game::checkLevelPack(const std::string& path) {
+    if (!loadToolResources()) return 1;
+    LevelPack pack;
+    if (!pack.open(path)) return 1;
+    
+    Level* stored = nullptr;
+    Level* generated = nullptr;
+    int mismatches = 0;
+    double loadMicros = 0;
+    for (size_t i = 0; i < pack.size(); i++) {
+        const LevelPack::Entry& entry = pack.entry(i);
+        LevelPack::View view;
+        if (!pack.view(entry, view)) {
+            printf("seed %lld difficulty %d type %d: record is damaged\n",
+                   (long long)entry.seed, entry.difficulty, entry.type);
+            mismatches++;
+            continue;
+        }
+        if (!stored || stored->width != view.header->width || stored->height != view.header->height) {
+            delete stored;
+            delete generated;
+            stored = new Level(view.header->width, view.header->height);
+            generated = new Level(view.header->width, view.header->height);
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        LevelPack::loadInto(view, stored);
+        loadMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        
+        LevelGenerator::generateInto(generated, entry.seed, entry.difficulty, entry.type);
+        if (stored->contentHash() != generated->contentHash()) {
+            printf("seed %lld difficulty %d type %d: differs from a freshly generated level\n",
+                   (long long)entry.seed, entry.difficulty, entry.type);
+            mismatches++;
+        }
+    }
+    delete stored;
+    delete generated;
+    
+    printf("%d of %zu levels differ from %s (%.1f us per load)\n", mismatches, pack.size(), path.c_str(),
+           pack.size() > 0 ? loadMicros / pack.size() : 0.0);
+    return mismatches > 0 ? 2 : 0;
+}
+
+// Files that are loaded through SDL and can live in the resource
+// archive; the rest (configs, soundfonts) are opened by path
+static bool isArchivedResource(const std::string& name) {
+    static const char* extensions[] = {".png", ".gif", ".wav", ".ogg", ".mid"};
+    for (const char* extension : extensions) {
+        size_t length = strlen(extension);
+        if (name.size() > length && name.compare(name.size() - length, length, extension) == 0) return true;
+    }
+    return false;
+}
+
+int Game::writeResourceArchive(const std::string& path, const std::string& directory) {
+    std::string dir = directory.empty() ? findResourcePath() : directory;
+    if (dir.empty()) {
+        std::cerr << "This build has its resources built in; name the directory to pack" << std::endl;
+        return 1;
+    }
+    if (dir.back() != '/' && dir.back() != '\\') dir += '/';
+    
+    ResourceArchiveWriter writer;
+    if (!writer.open(path)) return 1;
+    size_t files = 0;
+    uint64_t bytes = 0;
+    bool ok = true;
+    for (const std::string& name : ResourceIndex::listFiles(dir)) {
+        if (!isArchivedResource(name)) continue;
+        std::ifstream in(dir + name, std::ios::binary);
+        std::vector<uint8_t> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!in.good() && !in.eof()) {
+            std::cerr << "Could not read " << dir << name << std::endl;
+            ok = false;
+            break;
+        }
+        ok = writer.add(name, contents);
+        if (!ok) break;
+        files++;
+        bytes += contents.size();
+    }
+    if (!writer.finish() || !ok) {
+        std::cerr << "Failed to write resource archive: " << path << std::endl;
+        return 1;
+    }
+    
+    std::ifstream written(path, std::ios::binary | std::ios::ate);
+    printf("Wrote %zu files (%llu bytes) from %s to %s (%lld bytes)\n", files, (unsigned long long)bytes,
+           dir.c_str(), path.c_str(), (long long)written.tellg());
+    return 0;
+}
+
+int Game::checkResourceArchive(const std::string& path) {
+    ResourceArchive archive;
+    if (!archive.open(path)) return 1;
+    
+    int damaged = 0;
+    std::vector<uint8_t> contents;
+    for (size_t i = 0; i < archive.size(); i++) {
+        const ResourceArchive::Entry& entry = archive.entry(i);
+        std::string name(archive.name(entry));
+        auto start = std::chrono::steady_clock::now();
+        bool ok = archive.read(entry, contents) &&
+                  ResourceArchive::hashBytes(contents.data(), contents.size()) == entry.hash;
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        printf("%-24s %8llu -> %8llu bytes  %-6s %8.1f us%s\n", name.c_str(), (unsigned long long)entry.size,
+               (unsigned long long)entry.originalSize, entry.method == ResourceArchive::LZ4 ? "lz4" : "stored",
+               micros, ok ? "" : "  DAMAGED");
+        if (!ok) damaged++;
+    }
+    printf("%d of %zu files damaged in %s\n", damaged, archive.size(), path.c_str());
+    return damaged > 0 ? 2 : 0;
+}
+
+bool Game::useLevelPack(const std::string& path) {
+    std::unique_ptr<LevelPack> pack(new LevelPack());
+    if (!pack->open(path)) return false;
+    LevelCache::usePack(pack.get());
+    levelPack = std::move(pack);
+    DEBUG_PRINT("Using level pack %s (%zu levels)", path.c_str(), levelPack->size());
+    return true;
+}
+
+int Game::benchmarkTicks(int ticks) {
+    if (!loadToolResources()) return 1;
+    static const int WIDTHS[] = {320, 1000, 10000, 100000};
+    
+    // Mario idles on flat ground for as long as the benchmark runs
+    g_testMode = true;
+    printf("width,ticks,tick_us,rewind_us,rewind_bytes\n");
+    for (int width : WIDTHS) {
+        // Spawn points every few columns across the whole level, so the
+        // only thing that changes between rows is the level size
+        Level* level = new Level(width, LevelScene::LEVEL_HEIGHT);
+        for (int x = 0; x < width; x++) {
+            level->setBlock(x, LevelScene::LEVEL_HEIGHT - 2, 1 + 9 * 16);
+            level->setBlock(x, LevelScene::LEVEL_HEIGHT - 1, 1 + 9 * 16);
+            if (x >= 40 && x % 8 == 0) {
+                level->addSpriteTemplate(x, LevelScene::LEVEL_HEIGHT - 3, Enemy::ENEMY_GOOMBA, false);
+            }
+        }
+        Autotiler::apply(level, 0, 0, width);
+        level->xExit = width - 8;
+        level->yExit = LevelScene::LEVEL_HEIGHT - 3;
+        
+        LevelScene scene(nullptr, 0, 1, 0);
+        scene.adoptLevel(level, nullptr, nullptr);
+        scene.initLevel();
+        Rewind rewind;
+        for (int i = 0; i < TICKS_PER_SECOND; i++) {
+            scene.tick();
+            rewind.record(&scene);
+        }
+        
+        double tickMicros = 0;
+        double rewindMicros = 0;
+        for (int i = 0; i < ticks; i++) {
+            auto start = std::chrono::steady_clock::now();
+            scene.tick();
+            auto ticked = std::chrono::steady_clock::now();
+            rewind.record(&scene);
+            auto recorded = std::chrono::steady_clock::now();
+            tickMicros += std::chrono::duration<double, std::micro>(ticked - start).count();
+            rewindMicros += std::chrono::duration<double, std::micro>(recorded - ticked).count();
+        }
+        printf("%d,%d,%.2f,%.2f,%zu\n", width, ticks, tickMicros / ticks, rewindMicros / ticks,
+               rewind.memoryUsed());
+        fflush(stdout);
+    }
+    return 0;
+}
+
 Game::~Game() {
     cleanup();
 }
@@ -86,14 +494,7 @@ bool Game::init(bool useDefaultBindings) {
     }
     DEBUG_PRINT("SDL_image initialized OK");
     
-    // Initialize SDL_mixer
-    DEBUG_PRINT("Initializing SDL_mixer...");
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
-        std::cerr << "SDL_mixer initialization failed: " << Mix_GetError() << std::endl;
-        // Continue without sound
-    }
-    Mix_AllocateChannels(32);
-    DEBUG_PRINT("SDL_mixer initialized OK");
+    // SDL_mixer is opened by Art::init, off this thread
     
     // Initialize input configuration
     DEBUG_PRINT("Initializing InputConfig...");
@@ -191,13 +592,25 @@ bool Game::init(bool useDefaultBindings) {
     DEBUG_PRINT("Initializing volume from config...");
     Art::initVolumeFromConfig();
     
-    // Load tile behaviors (with user override support)
-    DEBUG_PRINT("Loading tile behaviors...");
-    if (!Level::loadBehaviors(Art::resolveResource("tiles.dat"))) {
-        std::cerr << "Failed to load tile behaviors!" << std::endl;
+    // Tile behaviors are built in; only a user's own tiles.dat is read
+    std::string userTiles = Art::findUserOverride("tiles.dat");
+    if (!userTiles.empty()) {
+        DEBUG_PRINT("Loading tile behaviors...");
+        if (!Level::loadBehaviors(userTiles)) {
+            std::cerr << "Failed to load tile behaviors!" << std::endl;
+            return false;
+        }
+        DEBUG_PRINT("Tile behaviors loaded OK");
+    }
+    
+    // Zone odds (with user override support); --zones may have set them
+    if (!loadZoneOdds()) {
+        std::cerr << "Failed to load zone odds!" << std::endl;
         return false;
     }
-    DEBUG_PRINT("Tile behaviors loaded OK");
+    
+    if (levelWidth <= 0) levelWidth = LevelScene::LEVEL_WIDTH;
+    pregenerator = new LevelPregenerator(levelWidth, LevelScene::LEVEL_HEIGHT);
     
     // Create map scene
     Random random;
@@ -211,24 +624,32 @@ bool Game::init(bool useDefaultBindings) {
 void Game::run() {
     running = true;
     
-    // Start with title screen (direct call is safe here - no scene exists yet)
-    doSceneChange(PendingScene::TITLE);
+    // Start with title screen, or go straight into a savestate or endless
+    // level queued from the command line (direct call is safe here - no
+    // scene exists yet)
+    PendingScene firstScene = PendingScene::TITLE;
+    if (pendingScene == PendingScene::LOAD_STATE || pendingScene == PendingScene::ENDLESS) {
+        firstScene = pendingScene;
+        pendingScene = PendingScene::NONE;
+    }
+    doSceneChange(firstScene);
     
     Uint32 lastTime = SDL_GetTicks();
     
     while (running) {
         Uint32 currentTime = SDL_GetTicks();
         
+        ResourceIndex::poll();
+        Art::updateAudio();
         handleEvents();
         updateGameInput();
         
-        if (scene) {
-            scene->tick();
-        }
+        tickScene();
         
         // Process any pending scene change AFTER tick completes
         // This prevents use-after-free when a scene triggers its own deletion
         processPendingSceneChange();
+        Art::flushSounds();
         
         // Update input state for next frame (MUST be called after all input checks)
         INPUTCFG.updatePreviousState();
@@ -258,6 +679,30 @@ void Game::run() {
     Art::stopMusic();
 }
 
+void Game::tickScene() {
+    if (!scene) return;
+    
+    LevelScene* levelScene = dynamic_cast<LevelScene*>(scene);
+    if (!levelScene) {
+        scene->tick();
+        return;
+    }
+    
+    if (rewinding) {
+        // Step back one tick; once the buffer runs out, hold on the oldest
+        if (rewind.ticksAvailable() > 0) {
+            rewind.restore(levelScene, 1);
+        }
+        return;
+    }
+    
+    scene->tick();
+    // Endless levels retire their columns, so there is nothing to rewind to
+    if (pendingScene == PendingScene::NONE && !levelScene->userPaused && !levelScene->isEndless()) {
+        rewind.record(levelScene);
+    }
+}
+
 void Game::handleEvents() {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
@@ -274,6 +719,15 @@ void Game::handleEvents() {
                     case SDLK_F1:
                         useScale2x = !useScale2x;
                         break;
+                    case SDLK_F2:
+                        saveState(SaveState::quickSavePath());
+                        break;
+                    case SDLK_F3:
+                        loadState(SaveState::quickSavePath());
+                        break;
+                    case SDLK_F4:
+                        rewinding = true;
+                        break;
                     case SDLK_F5:
                         Art::adjustSfxVolume(-16);   // Decrease SFX volume
                         break;
@@ -324,6 +778,11 @@ void Game::handleEvents() {
                         break;
                 }
                 break;
+            case SDL_KEYUP:
+                if (event.key.keysym.sym == SDLK_F4) {
+                    rewinding = false;
+                }
+                break;
             default:
                 break;
         }
@@ -347,13 +806,20 @@ void Game::updateGameInput() {
     }
 }
 
-void Game::startLevel(long seed, int difficulty, int type) {
+void Game::startLevel(int64_t seed, int difficulty, int type) {
     pendingScene = PendingScene::LEVEL;
     pendingLevelSeed = seed;
     pendingLevelDifficulty = difficulty;
     pendingLevelType = type;
 }
 
+void Game::startEndless(int64_t seed, int difficulty, int type) {
+    pendingScene = PendingScene::ENDLESS;
+    pendingLevelSeed = seed;
+    pendingLevelDifficulty = difficulty;
+    pendingLevelType = type;
+}
+
 void Game::levelFailed() {
     // Queue return to map scene - will be processed after LevelScene::tick() completes
     pendingScene = PendingScene::LEVEL_FAILED;
@@ -384,6 +850,28 @@ void Game::startGame() {
     pendingScene = PendingScene::START_GAME;
 }
 
+bool Game::saveState(const std::string& path) {
+    LevelScene* levelScene = dynamic_cast<LevelScene*>(scene);
+    if (!levelScene) {
+        DEBUG_PRINT("Savestates are only available inside a level");
+        return false;
+    }
+    if (levelScene->isEndless()) {
+        DEBUG_PRINT("Savestates are not available in endless levels");
+        return false;
+    }
+    return SaveState::save(levelScene, path);
+}
+
+void Game::loadState(const std::string& path) {
+    pendingScene = PendingScene::LOAD_STATE;
+    pendingStatePath = path;
+}
+
+void Game::pregenerateLevels(const std::vector<LevelKey>& keys) {
+    if (pregenerator) pregenerator->request(keys);
+}
+
 void Game::processPendingSceneChange() {
     if (pendingScene == PendingScene::NONE) {
         return;
@@ -396,6 +884,10 @@ void Game::processPendingSceneChange() {
 }
 
 void Game::doSceneChange(PendingScene sceneType) {
+    // Rewind history never carries over into another scene (a savestate
+    // that fails to load keeps the current one, see LOAD_STATE)
+    if (sceneType != PendingScene::LOAD_STATE) rewind.clear();
+    
     switch (sceneType) {
         case PendingScene::TITLE:
             DEBUG_PRINT("Changing to Title scene");
@@ -403,6 +895,7 @@ void Game::doSceneChange(PendingScene sceneType) {
             if (scene && scene != mapScene) {
                 delete scene;
             }
+            if (mapScene) mapScene->releaseArt();
             scene = new TitleScene(this);
             scene->init();
             break;
@@ -424,6 +917,7 @@ void Game::doSceneChange(PendingScene sceneType) {
             scene = mapScene;
             mapScene->startMusic();
             mapScene->init();
+            mapSceneStarted = true;
             break;
             
         case PendingScene::WIN:
@@ -444,14 +938,38 @@ void Game::doSceneChange(PendingScene sceneType) {
             scene->init();
             break;
             
-        case PendingScene::LEVEL:
+        case PendingScene::LEVEL: {
             DEBUG_PRINT("Starting level");
             if (scene && scene != mapScene) {
                 delete scene;
             }
-            scene = new LevelScene(this, pendingLevelSeed, pendingLevelDifficulty, pendingLevelType);
+            LevelScene* levelScene = new LevelScene(this, pendingLevelSeed, pendingLevelDifficulty, pendingLevelType);
+            levelScene->setLevelWidth(levelWidth);
+            PregeneratedLevel built;
+            if (pregenerator &&
+                pregenerator->take({pendingLevelSeed, pendingLevelDifficulty, pendingLevelType}, built)) {
+                DEBUG_PRINT("Using pregenerated level");
+                levelScene->adoptLevel(built.level, built.bgLevels[0], built.bgLevels[1]);
+            }
+            scene = levelScene;
+            scene->init();
+            break;
+        }
+            
+        case PendingScene::ENDLESS: {
+            DEBUG_PRINT("Starting endless level");
+            if (scene && scene != mapScene) {
+                delete scene;
+            }
+            // Dying returns to the map, so make sure one exists
+            if (!mapSceneStarted) {
+                mapScene->init();
+                mapSceneStarted = true;
+            }
+            scene = new LevelScene(this, pendingLevelSeed, pendingLevelDifficulty, pendingLevelType, true);
             scene->init();
             break;
+        }
             
         case PendingScene::LEVEL_FAILED:
             DEBUG_PRINT("Level failed - returning to map");
@@ -477,6 +995,27 @@ void Game::doSceneChange(PendingScene sceneType) {
             mapScene->levelWon();
             break;
             
+        case PendingScene::LOAD_STATE: {
+            DEBUG_PRINT("Loading savestate %s", pendingStatePath.c_str());
+            LevelScene* loaded = SaveState::load(this, pendingStatePath);
+            if (!loaded) {
+                // Keep the current scene; with none yet, fall back to the title
+                if (!scene) doSceneChange(PendingScene::TITLE);
+                break;
+            }
+            rewind.clear();
+            if (scene && scene != mapScene) {
+                delete scene;
+            }
+            // The level returns to the map when it ends, so make sure one exists
+            if (!mapSceneStarted) {
+                mapScene->init();
+                mapSceneStarted = true;
+            }
+            scene = loaded;
+            break;
+        }
+            
         case PendingScene::NONE:
             break;
     }
@@ -592,6 +1131,14 @@ void Game::cleanup() {
         delete mapScene;
         mapScene = nullptr;
     }
+    if (pregenerator) {
+        delete pregenerator;
+        pregenerator = nullptr;
+    }
+    if (levelPack) {
+        LevelCache::usePack(nullptr);
+        levelPack.reset();
+    }
     
     INPUTCFG.cleanup();
     Art::cleanup();
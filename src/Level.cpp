@@ -3,35 +3,87 @@
  * @brief Level data implementation.
  */
 #include "Level.h"
-#include "SpriteTemplate.h"
+#include "SaveState.h"
+#include "TileTables.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
-std::array<uint8_t, 256> Level::TILE_BEHAVIORS = {};
+std::array<uint8_t, 256> Level::TILE_BEHAVIORS = DEFAULT_TILE_BEHAVIORS;
+TileTables Level::TILE_TABLES = DEFAULT_TILE_TABLES;
 
-Level::Level(int width, int height) : width(width), height(height) {
+Level::Level(int width, int height) : width(width), height(height), endColumn(width) {
     xExit = 10;
     yExit = 10;
     
-    map.resize(width);
-    data.resize(width);
-    spriteTemplates.resize(width);
+    map.assign((size_t)width * height, 0);
+    data.assign((size_t)width * height, 0);
+    spriteTemplates.assign((size_t)width * height, nullptr);
+}
+
+void Level::reset() {
+    xExit = 10;
+    yExit = 10;
+    firstColumn = 0;
+    endColumn = width;
     
-    for (int x = 0; x < width; x++) {
-        map[x].resize(height, 0);
-        data[x].resize(height, 0);
-        spriteTemplates[x].resize(height, nullptr);
+    std::fill(map.begin(), map.end(), 0);
+    std::fill(data.begin(), data.end(), 0);
+    std::fill(spriteTemplates.begin(), spriteTemplates.end(), nullptr);
+    templateStorage.clear();
+    templateSlots.clear();
+    animatedCells.clear();
+}
+
+void Level::clearColumns(int x0, int x1) {
+    for (int x = x0; x < x1; x++) {
+        size_t start = (size_t)columnIndex(x) * height;
+        std::fill(map.begin() + start, map.begin() + start + height, 0);
+        std::fill(data.begin() + start, data.begin() + start + height, 0);
+        std::fill(spriteTemplates.begin() + start, spriteTemplates.begin() + start + height, nullptr);
     }
 }
 
-Level::~Level() {
-    for (int x = 0; x < width; x++) {
-        for (int y = 0; y < height; y++) {
-            if (spriteTemplates[x][y]) {
-                delete spriteTemplates[x][y];
-            }
+Level* Level::copy() const {
+    Level* level = new Level(width, height);
+    level->xExit = xExit;
+    level->yExit = yExit;
+    level->map = map;
+    level->data = data;
+    level->animatedCells = animatedCells;
+    for (size_t i = 0; i < spriteTemplates.size(); i++) {
+        if (const SpriteTemplate* st = spriteTemplates[i]) {
+            level->templateStorage.emplace_back(st->type, st->winged);
+            level->templateStorage.back().cell = (uint32_t)i;
+            level->spriteTemplates[i] = &level->templateStorage.back();
         }
     }
+    return level;
+}
+
+size_t Level::memoryUsage() const {
+    size_t bytes = sizeof(Level) + map.capacity() + data.capacity()
+                 + spriteTemplates.capacity() * sizeof(SpriteTemplate*);
+    return bytes + (templateStorage.size() + templateSlots.capacity()) * sizeof(SpriteTemplate);
+}
+
+uint64_t Level::contentHash() const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xff)) * 0x100000001b3ULL;
+        }
+    };
+    mix((uint32_t)width);
+    mix((uint32_t)height);
+    for (size_t i = 0; i < map.size(); i++) {
+        mix(map[i] | (data[i] << 8));
+        const SpriteTemplate* st = spriteTemplates[i];
+        if (st) mix(0x10000u | ((uint32_t)st->type << 1) | (st->winged ? 1u : 0u));
+    }
+    mix((uint32_t)xExit);
+    mix((uint32_t)yExit);
+    return hash;
 }
 
 bool Level::loadBehaviors(const std::string& path) {
@@ -41,13 +93,16 @@ bool Level::loadBehaviors(const std::string& path) {
         return false;
     }
     
-    file.read(reinterpret_cast<char*>(TILE_BEHAVIORS.data()), 256);
+    std::array<uint8_t, 256> behaviors;
+    file.read(reinterpret_cast<char*>(behaviors.data()), 256);
     std::streamsize bytesRead = file.gcount();
     
     if (bytesRead != 256) {
         std::cerr << "Expected 256 bytes, got " << bytesRead << std::endl;
         return false;
     }
+    TILE_BEHAVIORS = behaviors;
+    TILE_TABLES = TileTables::derive(behaviors);
     
     DEBUG_PRINT("Loaded tile behaviors from %s", path.c_str());
     return true;
@@ -64,55 +119,146 @@ bool Level::saveBehaviors(const std::string& path) {
 }
 
 void Level::tick() {
-    for (int x = 0; x < width; x++) {
-        for (int y = 0; y < height; y++) {
-            if (data[x][y] > 0) {
-                data[x][y]--;
-            }
+    size_t kept = 0;
+    for (uint32_t index : animatedCells) {
+        if (data[index] > 0) {
+            data[index]--;
+            logEdit(index, data[index], data[index] + 1, TileEdit::DATA);
         }
+        if (data[index] > 0) animatedCells[kept++] = index;
+    }
+    animatedCells.resize(kept);
+}
+
+void Level::findAnimatedCells() {
+    animatedCells.clear();
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] > 0) animatedCells.push_back((uint32_t)i);
     }
 }
 
 uint8_t Level::getBlockCapped(int x, int y) const {
-    if (x < 0) x = 0;
     if (y < 0) y = 0;
-    if (x >= width) x = width - 1;
     if (y >= height) y = height - 1;
-    return map[x][y];
+    return map[columnIndex(x) * height + y];
 }
 
 uint8_t Level::getBlock(int x, int y) const {
-    if (x < 0) x = 0;
     if (y < 0) return 0;
-    if (x >= width) x = width - 1;
     if (y >= height) y = height - 1;
-    return map[x][y];
+    return map[columnIndex(x) * height + y];
 }
 
 void Level::setBlock(int x, int y, uint8_t b) {
-    if (x < 0 || y < 0 || x >= width || y >= height) return;
-    map[x][y] = b;
+    if (!inside(x, y)) return;
+    int index = columnIndex(x) * height + y;
+    logEdit(index, b, map[index], TileEdit::TILE);
+    map[index] = b;
 }
 
 void Level::setBlockData(int x, int y, uint8_t b) {
-    if (x < 0 || y < 0 || x >= width || y >= height) return;
-    data[x][y] = b;
+    if (!inside(x, y)) return;
+    int index = columnIndex(x) * height + y;
+    logEdit(index, b, data[index], TileEdit::DATA);
+    data[index] = b;
+    // The list stays tiny (blocks bumped in the last few ticks)
+    if (b > 0 && std::find(animatedCells.begin(), animatedCells.end(), index) == animatedCells.end()) {
+        animatedCells.push_back(index);
+    }
+}
+
+void Level::revertEdit(const TileEdit& edit) {
+    if (edit.index >= map.size()) return;
+    SpriteTemplate* st = spriteTemplates[edit.index];
+    switch (edit.kind) {
+        case TileEdit::TILE:
+            map[edit.index] = (uint8_t)edit.old;
+            break;
+        case TileEdit::DATA:
+            data[edit.index] = (uint8_t)edit.old;
+            if (edit.old > 0 &&
+                std::find(animatedCells.begin(), animatedCells.end(), edit.index) == animatedCells.end()) {
+                animatedCells.push_back(edit.index);
+            }
+            break;
+        case TileEdit::TEMPLATE_DEAD:
+            if (st) st->isDead = edit.old != 0;
+            break;
+        case TileEdit::TEMPLATE_SEEN:
+            if (st) st->lastVisibleTick = edit.old;
+            break;
+    }
+}
+
+void Level::markTemplateDead(SpriteTemplate* st) {
+    logEdit(st->cell, 1, st->isDead ? 1 : 0, TileEdit::TEMPLATE_DEAD);
+    st->isDead = true;
+}
+
+void Level::markTemplateSeen(SpriteTemplate* st, int tick) {
+    logEdit(st->cell, tick, st->lastVisibleTick, TileEdit::TEMPLATE_SEEN);
+    st->lastVisibleTick = tick;
+}
+
+uint8_t Level::getBlockData(int x, int y) const {
+    if (!inside(x, y)) return 0;
+    return data[columnIndex(x) * height + y];
 }
 
 bool Level::isBlocking(int x, int y, float xa, float ya) const {
-    uint8_t block = getBlock(x, y);
-    bool blocking = (TILE_BEHAVIORS[block] & BIT_BLOCK_ALL) > 0;
-    blocking |= (ya > 0) && ((TILE_BEHAVIORS[block] & BIT_BLOCK_UPPER) > 0);
-    blocking |= (ya < 0) && ((TILE_BEHAVIORS[block] & BIT_BLOCK_LOWER) > 0);
-    return blocking;
+    uint8_t direction = ya > 0 ? TileTables::SOLID_FALLING
+                      : ya < 0 ? TileTables::SOLID_RISING : TileTables::SOLID_SIDEWAYS;
+    return (TILE_TABLES.solidity[getBlock(x, y)] & direction) != 0;
 }
 
 SpriteTemplate* Level::getSpriteTemplate(int x, int y) const {
-    if (x < 0 || y < 0 || x >= width || y >= height) return nullptr;
-    return spriteTemplates[x][y];
+    if (!inside(x, y)) return nullptr;
+    return spriteTemplates[columnIndex(x) * height + y];
 }
 
-void Level::setSpriteTemplate(int x, int y, SpriteTemplate* spriteTemplate) {
-    if (x < 0 || y < 0 || x >= width || y >= height) return;
-    spriteTemplates[x][y] = spriteTemplate;
+SpriteTemplate* Level::addSpriteTemplate(int x, int y, int type, bool winged) {
+    if (!inside(x, y)) return nullptr;
+    int index = columnIndex(x) * height + y;
+    if (wrapColumns) {
+        if (templateSlots.empty()) templateSlots.assign(map.size(), SpriteTemplate(0, false));
+        templateSlots[index] = SpriteTemplate(type, winged);
+        spriteTemplates[index] = &templateSlots[index];
+    } else {
+        templateStorage.emplace_back(type, winged);
+        spriteTemplates[index] = &templateStorage.back();
+    }
+    spriteTemplates[index]->cell = (uint32_t)index;
+    return spriteTemplates[index];
+}
+
+void Level::writeState(StateWriter& out) const {
+    out.write<int32_t>(width);
+    out.write<int32_t>(height);
+    out.write<int32_t>(xExit);
+    out.write<int32_t>(yExit);
+    out.writeBytes(map.data(), map.size());
+    out.writeBytes(data.data(), data.size());
+}
+
+Level* Level::readState(StateReader& in) {
+    int w = in.read<int32_t>();
+    int h = in.read<int32_t>();
+    // Reject nonsense sizes before allocating (max 16M tiles, room for
+    // levels of a million columns)
+    if (!in.good() || w <= 0 || h <= 0 || (int64_t)w * h > (1 << 24)) {
+        return nullptr;
+    }
+    
+    Level* level = new Level(w, h);
+    level->xExit = in.read<int32_t>();
+    level->yExit = in.read<int32_t>();
+    in.readBytes(level->map.data(), level->map.size());
+    in.readBytes(level->data.data(), level->data.size());
+    
+    if (!in.good()) {
+        delete level;
+        return nullptr;
+    }
+    level->findAnimatedCells();
+    return level;
 }
@@ -0,0 +1,115 @@
+/**
+ * @file LevelCache.cpp
+ * @brief Level cache implementation.
+ */
+#include "LevelCache.h"
+#include "LevelGenerator.h"
+#include "Level.h"
+#include "LevelPack.h"
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+typedef std::tuple<int64_t, int, int, int, int> CacheKey;  // seed, difficulty, type, width, height
+
+struct CacheEntry {
+    CacheKey key;
+    Level* level;
+    size_t bytes;
+};
+
+// Default budget holds roughly 150 standard 320x15 levels
+static size_t budget = 8 * 1024 * 1024;
+static size_t bytesUsed = 0;
+static size_t hitCount = 0;
+static size_t missCount = 0;
+
+static std::list<CacheEntry> cacheEntries;  // Most recently used first
+static std::map<CacheKey, std::list<CacheEntry>::iterator> cacheIndex;
+static std::mutex cacheMutex;
+static std::atomic<const LevelPack*> levelPack(nullptr);
+
+static void evictToFit(size_t limit) {
+    while (bytesUsed > limit && !cacheEntries.empty()) {
+        CacheEntry& victim = cacheEntries.back();
+        bytesUsed -= victim.bytes;
+        cacheIndex.erase(victim.key);
+        delete victim.level;
+        cacheEntries.pop_back();
+    }
+}
+
+// A level from the pack, if it holds one of this size
+static Level* loadFromPack(int width, int height, const LevelKey& key) {
+    const LevelPack* pack = levelPack.load();
+    const LevelPack::Entry* entry = pack ? pack->find(key) : nullptr;
+    LevelPack::View stored;
+    if (!entry || !pack->view(*entry, stored) ||
+        stored.header->width != width || stored.header->height != height) {
+        return nullptr;
+    }
+    Level* level = new Level(width, height);
+    LevelPack::loadInto(stored, level);
+    return level;
+}
+
+Level* LevelCache::acquire(int width, int height, int64_t seed, int difficulty, int type) {
+    // Loading from a mapped pack is as cheap as copying a cached level
+    if (Level* packed = loadFromPack(width, height, {seed, difficulty, type})) {
+        return packed;
+    }
+    
+    CacheKey key(seed, difficulty, type, width, height);
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cacheIndex.find(key);
+        if (it != cacheIndex.end()) {
+            cacheEntries.splice(cacheEntries.begin(), cacheEntries, it->second);
+            hitCount++;
+            return it->second->level->copy();
+        }
+        missCount++;
+    }
+    
+    // Generate outside the lock so other threads are not held up
+    Level* level = LevelGenerator::createLevel(width, height, seed, difficulty, type);
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    size_t bytes = level->memoryUsage();
+    if (budget == 0 || bytes > budget || cacheIndex.count(key)) {
+        return level;
+    }
+    Level* pristine = level->copy();
+    cacheEntries.push_front({key, pristine, bytes});
+    cacheIndex[key] = cacheEntries.begin();
+    bytesUsed += bytes;
+    evictToFit(budget);
+    return level;
+}
+
+void LevelCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    budget = bytes;
+    evictToFit(budget);
+}
+
+void LevelCache::clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    evictToFit(0);
+}
+
+void LevelCache::usePack(const LevelPack* pack) {
+    levelPack = pack;
+}
+
+size_t LevelCache::hits() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return hitCount;
+}
+
+size_t LevelCache::misses() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return missCount;
+}
@@ -4,31 +4,237 @@
  */
 #include "LevelGenerator.h"
 #include "Level.h"
-#include "SpriteTemplate.h"
 #include "Enemy.h"
+#include "Autotiler.h"
 #include <algorithm>
 #include <vector>
+#include <atomic>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <thread>
 
 // Constants matching Java
 const int LevelGenerator::TYPE_OVERGROUND = 0;
 const int LevelGenerator::TYPE_UNDERGROUND = 1;
 const int LevelGenerator::TYPE_CASTLE = 2;
 
-const int LevelGenerator::ODDS_STRAIGHT = 0;
-const int LevelGenerator::ODDS_HILL_STRAIGHT = 1;
-const int LevelGenerator::ODDS_TUBES = 2;
-const int LevelGenerator::ODDS_JUMP = 3;
-const int LevelGenerator::ODDS_CANNONS = 4;
+static const char* TYPE_NAMES[] = {"overground", "underground", "castle"};
 
-Level* LevelGenerator::createLevel(int width, int height, long seed, int difficulty, int type) {
-    LevelGenerator gen(width, height);
-    return gen.createLevelInternal(seed, difficulty, type);
+// Built-in odds match the Java original
+const LevelGenerator::ZoneBuilder LevelGenerator::ZONE_BUILDERS[ZONE_COUNT] = {
+    {"straight", &LevelGenerator::buildStraightZone, {20, 0, 0, 1 << 20, 7}},
+    {"hill_straight", &LevelGenerator::buildHillStraight, {10, 0, 0, 1 << 20, 1 << 0}},
+    {"tubes", &LevelGenerator::buildTubes, {2, 1, 0, 1 << 20, 7}},
+    {"jump", &LevelGenerator::buildJump, {0, 2, 0, 1 << 20, 7}},
+    {"cannons", &LevelGenerator::buildCannons, {-10, 5, 0, 1 << 20, 7}},
+};
+
+int ZoneWeight::at(int difficulty, int type) const {
+    if (type < 0 || type > 2 || !(typeMask & (1 << type))) return 0;
+    int64_t weight = base + (int64_t)perDifficulty * difficulty;
+    return (int)std::max<int64_t>(std::max(min, 0), std::min<int64_t>(weight, max));
+}
+
+// Odds are compiled for the difficulties the game reaches; others are
+// compiled per level
+static const int PRECOMPILED_DIFFICULTIES = 32;
+
+struct ZoneTables {
+    ZoneWeight weights[LevelGenerator::ZONE_COUNT];
+    LevelGenerator::ZoneOdds odds[3][PRECOMPILED_DIFFICULTIES];
+    bool loaded = false;  ///< A config file has been applied
+    
+    ZoneTables();
+    void compile();
+};
+
+static LevelGenerator::ZoneOdds compileOdds(const ZoneWeight* weights, int difficulty, int type) {
+    LevelGenerator::ZoneOdds odds;
+    for (int i = 0; i < LevelGenerator::ZONE_COUNT; i++) {
+        int weight = weights[i].at(difficulty, type);
+        if (weight <= 0 || odds.total > INT_MAX - weight) continue;
+        odds.total += weight;
+        odds.end[odds.count] = odds.total;
+        odds.zone[odds.count] = (uint8_t)i;
+        odds.count++;
+    }
+    return odds;
+}
+
+ZoneTables::ZoneTables() {
+    for (int i = 0; i < LevelGenerator::ZONE_COUNT; i++) {
+        weights[i] = LevelGenerator::ZONE_BUILDERS[i].defaults;
+    }
+    compile();
+}
+
+void ZoneTables::compile() {
+    for (int type = 0; type < 3; type++) {
+        for (int d = 0; d < PRECOMPILED_DIFFICULTIES; d++) {
+            odds[type][d] = compileOdds(weights, d, type);
+        }
+    }
+}
+
+// Built on first use, so levels generated before (or without)
+// loadZoneConfig get the defaults
+static ZoneTables& zoneTables() {
+    static ZoneTables tables;
+    return tables;
+}
+
+static std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+static bool parseInt(const std::string& text, int& out) {
+    char* end = nullptr;
+    long value = strtol(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != '\0') return false;
+    out = (int)std::max<long>(INT_MIN / 2, std::min<long>(value, INT_MAX / 2));
+    return true;
+}
+
+bool LevelGenerator::loadZoneConfig(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open zone config: " << path << std::endl;
+        return false;
+    }
+    return loadZoneConfig(file, path);
+}
+
+bool LevelGenerator::loadZoneConfig(std::istream& file, const std::string& path) {
+    ZoneWeight weights[ZONE_COUNT];
+    for (int i = 0; i < ZONE_COUNT; i++) {
+        weights[i] = ZONE_BUILDERS[i].defaults;
+    }
+    
+    ZoneWeight* current = nullptr;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+        
+        if (line[0] == '[' && line.back() == ']') {
+            std::string name = trim(line.substr(1, line.length() - 2));
+            current = nullptr;
+            for (int i = 0; i < ZONE_COUNT; i++) {
+                if (name == ZONE_BUILDERS[i].name) current = &weights[i];
+            }
+            if (!current) {
+                std::cerr << path << ":" << lineNumber << ": unknown zone type [" << name << "]" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        
+        size_t eqPos = line.find('=');
+        if (!current || eqPos == std::string::npos) {
+            std::cerr << path << ":" << lineNumber << ": expected [zone] or key = value" << std::endl;
+            return false;
+        }
+        std::string key = trim(line.substr(0, eqPos));
+        std::string value = trim(line.substr(eqPos + 1));
+        
+        bool ok = true;
+        if (key == "base") {
+            ok = parseInt(value, current->base);
+        } else if (key == "per_difficulty") {
+            ok = parseInt(value, current->perDifficulty);
+        } else if (key == "min") {
+            ok = parseInt(value, current->min);
+        } else if (key == "max") {
+            ok = parseInt(value, current->max);
+        } else if (key == "types") {
+            std::replace(value.begin(), value.end(), ',', ' ');
+            std::istringstream names(value);
+            std::string name;
+            current->typeMask = 0;
+            while (names >> name) {
+                int type = -1;
+                for (int t = 0; t < 3; t++) {
+                    if (name == TYPE_NAMES[t]) type = t;
+                }
+                if (type < 0) {
+                    ok = false;
+                    break;
+                }
+                current->typeMask |= 1 << type;
+            }
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << path << ":" << lineNumber << ": bad setting '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+    
+    ZoneTables& tables = zoneTables();
+    std::copy(weights, weights + ZONE_COUNT, tables.weights);
+    tables.compile();
+    tables.loaded = true;
+    DEBUG_PRINT("Loaded zone odds from %s", path.c_str());
+    return true;
+}
+
+bool LevelGenerator::zoneConfigLoaded() {
+    return zoneTables().loaded;
+}
+
+Level* LevelGenerator::createLevel(int width, int height, int64_t seed, int difficulty, int type) {
+    Level* level = new Level(width, height);
+    LevelGenerator gen;
+    gen.generate(level, seed, difficulty, type);
+    return level;
+}
+
+void LevelGenerator::generateInto(Level* level, int64_t seed, int difficulty, int type) {
+    LevelGenerator gen;
+    gen.generate(level, seed, difficulty, type);
 }
 
-Level* LevelGenerator::createBgLevel(int width, int height, bool distant, int type) {
-    static Random bgRandom;
+bool LevelGenerator::generateInto(Level* level, int64_t seed, int difficulty, int type,
+                                  const GenerateOptions& options) {
+    LevelGenerator gen;
+    return gen.generate(level, seed, difficulty, type, &options);
+}
+
+void LevelGenerator::generateBatch(const std::vector<int64_t>& seeds, int difficulty, int type,
+                                   const std::vector<Level*>& levels, int threads) {
+    size_t count = std::min(seeds.size(), levels.size());
+    if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    threads = (int)std::min<size_t>(threads, count);
+    
+    // Each worker keeps one generator so its scratch buffers are reused
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        LevelGenerator gen;
+        for (size_t i = next++; i < count; i = next++) {
+            gen.generate(levels[i], seeds[i], difficulty, type);
+        }
+    };
+    
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+Level* LevelGenerator::createBgLevel(int width, int height, bool distant, int type, int64_t seed) {
     Level* level = new Level(width, height);
-    Random random(bgRandom.nextLong());
+    Random random(seed);
     
     switch (type) {
         case TYPE_OVERGROUND:
@@ -97,38 +303,48 @@ Level* LevelGenerator::createBgLevel(int width, int height, bool distant, int ty
     return level;
 }
 
-LevelGenerator::LevelGenerator(int width, int height) : width(width), height(height) {
-    for (int i = 0; i < 5; i++) odds[i] = 0;
-}
+LevelGenerator::LevelGenerator()
+    : width(0), height(0), zoneOdds(nullptr), level(nullptr), placeSprites(true), ceiling(0), ceilingRun(0) {}
 
-Level* LevelGenerator::createLevelInternal(long seed, int difficulty, int type) {
+void LevelGenerator::start(Level* target, int64_t seed, int difficulty, int type, bool sprites) {
+    level = target;
+    placeSprites = sprites;
+    width = target->width;
+    height = target->height;
+    level->reset();
+    
     this->type = type;
     this->difficulty = difficulty;
-    totalOdds = 0;
-    
-    odds[ODDS_STRAIGHT] = 20;
-    odds[ODDS_HILL_STRAIGHT] = 10;
-    odds[ODDS_TUBES] = 2 + difficulty;
-    odds[ODDS_JUMP] = 2 * difficulty;
-    odds[ODDS_CANNONS] = -10 + 5 * difficulty;
-    
-    if (type != TYPE_OVERGROUND) {
-        odds[ODDS_HILL_STRAIGHT] = 0;
-    }
-    
-    for (int i = 0; i < 5; i++) {
-        if (odds[i] < 0) odds[i] = 0;
-        totalOdds += odds[i];
-        odds[i] = totalOdds - odds[i];
+    if (difficulty >= 0 && difficulty < PRECOMPILED_DIFFICULTIES && type >= 0 && type < 3) {
+        zoneOdds = &zoneTables().odds[type][difficulty];
+    } else {
+        oddsScratch = compileOdds(zoneTables().weights, difficulty, type);
+        zoneOdds = &oddsScratch;
     }
     
-    level = new Level(width, height);
     random = Random(seed);
+    ceiling = 0;
+    ceilingRun = 0;
+}
+
+bool LevelGenerator::generate(Level* target, int64_t seed, int difficulty, int type,
+                              const GenerateOptions* options) {
+    start(target, seed, difficulty, type, !options || options->spriteTemplates);
+    
+    // Ground is tiled zone by zone, so zoneDone sees finished columns
+    bool autotile = !options || options->autotile;
+    auto keepGoing = [&](int x0, int x1) {
+        if (autotile) Autotiler::apply(level, type, x0, x1);
+        return !options || !options->zoneDone || options->zoneDone(*level, x0, x1);
+    };
     
     int length = 0;
     length += buildStraight(0, level->width, true);
+    if (!keepGoing(0, length)) return false;
     while (length < level->width - 64) {
+        int zoneStart = length;
         length += buildZone(length, level->width - length);
+        if (!keepGoing(zoneStart, length)) return false;
     }
     
     int floor = height - 1 - random.nextInt(4);
@@ -146,49 +362,27 @@ Level* LevelGenerator::createLevelInternal(long seed, int difficulty, int type)
     }
     
     // Add ceiling for castle/underground
+    int retileFrom = length;
     if (type == TYPE_CASTLE || type == TYPE_UNDERGROUND) {
-        int ceiling = 0;
-        int run = 0;
-        for (int x = 0; x < level->width; x++) {
-            if (run-- <= 0 && x > 4) {
-                ceiling = random.nextInt(4);
-                run = random.nextInt(4) + 4;
-            }
-            for (int y = 0; y < level->height; y++) {
-                if ((x > 4 && y <= ceiling) || x < 1) {
-                    level->setBlock(x, y, (uint8_t)(1 + 9 * 16));
-                }
-            }
-        }
+        retileFrom = 0;
+        buildCeiling(0, level->width);
     }
     
-    fixWalls();
-    
-    return level;
+    if (autotile) {
+        Autotiler::apply(level, type, retileFrom, level->width);
+    }
+    return true;
 }
 
 int LevelGenerator::buildZone(int x, int maxLength) {
-    int t = random.nextInt(totalOdds);
-    int zoneType = 0;
-    for (int i = 0; i < 5; i++) {
-        if (odds[i] <= t) {
-            zoneType = i;
-        }
-    }
+    if (zoneOdds->count == 0) return buildStraight(x, maxLength, false);
     
-    switch (zoneType) {
-        case ODDS_STRAIGHT:
-            return buildStraight(x, maxLength, false);
-        case ODDS_HILL_STRAIGHT:
-            return buildHillStraight(x, maxLength);
-        case ODDS_TUBES:
-            return buildTubes(x, maxLength);
-        case ODDS_JUMP:
-            return buildJump(x, maxLength);
-        case ODDS_CANNONS:
-            return buildCannons(x, maxLength);
+    int t = random.nextInt(zoneOdds->total);
+    int i = 0;
+    while (t >= zoneOdds->end[i]) {
+        i++;
     }
-    return 0;
+    return (this->*ZONE_BUILDERS[zoneOdds->zone[i]].build)(x, maxLength);
 }
 
 int LevelGenerator::buildStraight(int xo, int maxLength, bool safe) {
@@ -214,6 +408,10 @@ int LevelGenerator::buildStraight(int xo, int maxLength, bool safe) {
     return length;
 }
 
+int LevelGenerator::buildStraightZone(int xo, int maxLength) {
+    return buildStraight(xo, maxLength, false);
+}
+
 int LevelGenerator::buildHillStraight(int xo, int maxLength) {
     int length = random.nextInt(10) + 10;
     if (length > maxLength) length = maxLength;
@@ -294,10 +492,9 @@ int LevelGenerator::buildTubes(int xo, int maxLength) {
         }
         if (xTube >= xo + length - 2) xTube += 10;
         
-        if (x == xTube && random.nextInt(11) < difficulty + 1) {
+        if (x == xTube && random.nextInt(11) < difficulty + 1 && placeSprites) {
             // Add flower enemy in tube
-            SpriteTemplate* st = new SpriteTemplate(Enemy::ENEMY_FLOWER, false);
-            level->setSpriteTemplate(x, tubeHeight, st);
+            level->addSpriteTemplate(x, tubeHeight, Enemy::ENEMY_FLOWER, false);
         }
         
         for (int y = 0; y < height; y++) {
@@ -389,6 +586,22 @@ int LevelGenerator::buildCannons(int xo, int maxLength) {
     return length;
 }
 
+// Runs of 4-7 columns at a random height, continuing the run left
+// by the previous call. Column 0 is a wall; columns 1-4 stay open.
+void LevelGenerator::buildCeiling(int x0, int x1) {
+    for (int x = x0; x < x1; x++) {
+        if (ceilingRun-- <= 0 && x > 4) {
+            ceiling = random.nextInt(4);
+            ceilingRun = random.nextInt(4) + 4;
+        }
+        for (int y = 0; y < height; y++) {
+            if ((x > 4 && y <= ceiling) || x < 1) {
+                level->setBlock(x, y, (uint8_t)(1 + 9 * 16));
+            }
+        }
+    }
+}
+
 void LevelGenerator::decorate(int x0, int x1, int floor) {
     if (floor < 1) return;
     
@@ -452,105 +665,9 @@ void LevelGenerator::addEnemyLine(int x0, int x1, int y) {
             } else if (difficulty < 3) {
                 enemyType = random.nextInt(3);
             }
-            SpriteTemplate* st = new SpriteTemplate(enemyType, random.nextInt(35) < difficulty);
-            level->setSpriteTemplate(x, y, st);
-        }
-    }
-}
-
-void LevelGenerator::fixWalls() {
-    // Create a boolean map indicating which positions are filled with ground
-    std::vector<std::vector<bool>> blockMap(width + 1, std::vector<bool>(height + 1, false));
-    
-    for (int x = 0; x <= width; x++) {
-        for (int y = 0; y <= height; y++) {
-            int blocks = 0;
-            for (int xx = x - 1; xx < x + 1; xx++) {
-                for (int yy = y - 1; yy < y + 1; yy++) {
-                    if (level->getBlockCapped(xx, yy) == (uint8_t)(1 + 9 * 16)) {
-                        blocks++;
-                    }
-                }
-            }
-            blockMap[x][y] = (blocks == 4);
-        }
-    }
-    
-    // Determine tile offset based on level type
-    int to = 0;
-    if (type == TYPE_CASTLE) {
-        to = 4 * 2;  // 8
-    } else if (type == TYPE_UNDERGROUND) {
-        to = 4 * 3;  // 12
-    }
-    
-    // Apply edge/corner tiles based on surrounding blocks
-    bool b[2][2];
-    for (int x = 0; x < width; x++) {
-        for (int y = 0; y < height; y++) {
-            for (int xx = x; xx <= x + 1; xx++) {
-                for (int yy = y; yy <= y + 1; yy++) {
-                    int _xx = xx;
-                    int _yy = yy;
-                    if (_xx < 0) _xx = 0;
-                    if (_yy < 0) _yy = 0;
-                    if (_xx > width) _xx = width;
-                    if (_yy > height) _yy = height;
-                    b[xx - x][yy - y] = blockMap[_xx][_yy];
-                }
-            }
-            
-            if (b[0][0] == b[1][0] && b[0][1] == b[1][1]) {
-                if (b[0][0] == b[0][1]) {
-                    if (b[0][0]) {
-                        level->setBlock(x, y, (uint8_t)(1 + 9 * 16 + to));  // Center fill
-                    }
-                    // else: keep old block
-                } else {
-                    if (b[0][0]) {
-                        level->setBlock(x, y, (uint8_t)(1 + 10 * 16 + to));  // Bottom edge
-                    } else {
-                        level->setBlock(x, y, (uint8_t)(1 + 8 * 16 + to));   // Top edge
-                    }
-                }
-            } else if (b[0][0] == b[0][1] && b[1][0] == b[1][1]) {
-                if (b[0][0]) {
-                    level->setBlock(x, y, (uint8_t)(2 + 9 * 16 + to));  // Right edge
-                } else {
-                    level->setBlock(x, y, (uint8_t)(0 + 9 * 16 + to));  // Left edge
-                }
-            } else if (b[0][0] == b[1][1] && b[0][1] == b[1][0]) {
-                level->setBlock(x, y, (uint8_t)(1 + 9 * 16 + to));  // Center fill (diagonal)
-            } else if (b[0][0] == b[1][0]) {
-                if (b[0][0]) {
-                    if (b[0][1]) {
-                        level->setBlock(x, y, (uint8_t)(3 + 10 * 16 + to));  // Inside corner bottom-right
-                    } else {
-                        level->setBlock(x, y, (uint8_t)(3 + 11 * 16 + to));  // Outside corner
-                    }
-                } else {
-                    if (b[0][1]) {
-                        level->setBlock(x, y, (uint8_t)(2 + 8 * 16 + to));   // Top-right corner
-                    } else {
-                        level->setBlock(x, y, (uint8_t)(0 + 8 * 16 + to));   // Top-left corner
-                    }
-                }
-            } else if (b[0][1] == b[1][1]) {
-                if (b[0][1]) {
-                    if (b[0][0]) {
-                        level->setBlock(x, y, (uint8_t)(3 + 9 * 16 + to));   // Inside corner
-                    } else {
-                        level->setBlock(x, y, (uint8_t)(3 + 8 * 16 + to));   // Outside corner
-                    }
-                } else {
-                    if (b[0][0]) {
-                        level->setBlock(x, y, (uint8_t)(2 + 10 * 16 + to));  // Bottom-right corner
-                    } else {
-                        level->setBlock(x, y, (uint8_t)(0 + 10 * 16 + to));  // Bottom-left corner
-                    }
-                }
-            } else {
-                level->setBlock(x, y, (uint8_t)(0 + 1 * 16 + to));  // Fallback
+            bool winged = random.nextInt(35) < difficulty;
+            if (placeSprites) {
+                level->addSpriteTemplate(x, y, enemyType, winged);
             }
         }
     }
@@ -0,0 +1,204 @@
+/**
+ * @file LevelPack.cpp
+ * @brief Level pack reading and writing.
+ */
+#include "LevelPack.h"
+#include "Level.h"
+#include "SpriteTemplate.h"
+#include <cstring>
+#include <type_traits>
+
+static_assert(sizeof(LevelPack::Header) == 24, "LevelPack::Header layout");
+static_assert(sizeof(LevelPack::Entry) == 32, "LevelPack::Entry layout");
+static_assert(sizeof(LevelPack::LevelHeader) == 24, "LevelPack::LevelHeader layout");
+static_assert(sizeof(LevelPack::Template) == 8, "LevelPack::Template layout");
+
+// Same limit as savestates (Level::readState)
+static const int64_t MAX_TILES = 1 << 24;
+
+static bool keyLess(const LevelKey& a, const LevelKey& b) {
+    if (a.seed != b.seed) return a.seed < b.seed;
+    if (a.difficulty != b.difficulty) return a.difficulty < b.difficulty;
+    return a.type < b.type;
+}
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Offset of the template array within a record
+static size_t templatesOffset(const LevelPack::LevelHeader& header) {
+    size_t tiles = (size_t)header.width * header.height;
+    size_t arrays = (header.flags & LevelPack::LEVEL_HAS_DATA) ? 2 : 1;
+    return alignUp(sizeof(LevelPack::LevelHeader) + arrays * tiles, alignof(LevelPack::Template));
+}
+
+bool LevelPack::open(const std::string& path) {
+    index = nullptr;
+    count = 0;
+    if (!file.open(path)) {
+        std::cerr << "Could not open level pack: " << path << std::endl;
+        return false;
+    }
+    
+    Header header;
+    if (file.size() < sizeof(header)) {
+        std::cerr << "Not a level pack: " << path << std::endl;
+        file.close();
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != MAGIC) {
+        std::cerr << "Not a level pack: " << path << std::endl;
+        file.close();
+        return false;
+    }
+    if (header.version != VERSION) {
+        std::cerr << "Unsupported level pack version " << header.version
+                  << " (expected " << VERSION << "): " << path << std::endl;
+        file.close();
+        return false;
+    }
+    if (header.indexOffset % alignof(Entry) != 0 || header.indexOffset > file.size() ||
+        header.levelCount > (file.size() - header.indexOffset) / sizeof(Entry)) {
+        std::cerr << "Level pack index is damaged: " << path << std::endl;
+        file.close();
+        return false;
+    }
+    
+    index = reinterpret_cast<const Entry*>(file.data() + header.indexOffset);
+    count = header.levelCount;
+    return true;
+}
+
+const LevelPack::Entry* LevelPack::find(const LevelKey& key) const {
+    const Entry* end = index + count;
+    const Entry* it = std::lower_bound(index, end, key, [](const Entry& entry, const LevelKey& key) {
+        return keyLess(entry.key(), key);
+    });
+    return (it != end && it->key() == key) ? it : nullptr;
+}
+
+bool LevelPack::view(const Entry& entry, View& out) const {
+    if (entry.offset % alignof(LevelHeader) != 0 || entry.offset > file.size() ||
+        entry.size > file.size() - entry.offset || entry.size < sizeof(LevelHeader)) {
+        return false;
+    }
+    const uint8_t* record = file.data() + entry.offset;
+    const LevelHeader* header = reinterpret_cast<const LevelHeader*>(record);
+    int64_t tiles = (int64_t)header->width * header->height;
+    if (header->width <= 0 || header->height <= 0 || tiles > MAX_TILES ||
+        templatesOffset(*header) + (uint64_t)header->templateCount * sizeof(Template) > entry.size) {
+        return false;
+    }
+    
+    out.header = header;
+    out.map = record + sizeof(LevelHeader);
+    out.data = (header->flags & LEVEL_HAS_DATA) ? out.map + tiles : nullptr;
+    out.templates = reinterpret_cast<const Template*>(record + templatesOffset(*header));
+    return true;
+}
+
+bool LevelPack::loadInto(const View& view, Level* level) {
+    const LevelHeader& header = *view.header;
+    if (level->width != header.width || level->height != header.height) return false;
+    
+    level->reset();
+    std::memcpy(level->map.data(), view.map, level->map.size());
+    if (view.data) std::memcpy(level->data.data(), view.data, level->data.size());
+    level->xExit = header.xExit;
+    level->yExit = header.yExit;
+    for (uint32_t i = 0; i < header.templateCount; i++) {
+        const Template& stored = view.templates[i];
+        if (stored.cell >= level->map.size()) continue;
+        level->addSpriteTemplate(stored.cell / level->height, stored.cell % level->height,
+                                 stored.type, stored.winged != 0);
+    }
+    if (view.data) level->findAnimatedCells();
+    return true;
+}
+
+Level* LevelPack::load(const LevelKey& key) const {
+    const Entry* entry = find(key);
+    View stored;
+    if (!entry || !view(*entry, stored)) return nullptr;
+    Level* level = new Level(stored.header->width, stored.header->height);
+    loadInto(stored, level);
+    return level;
+}
+
+LevelPackWriter::~LevelPackWriter() {
+    if (out) fclose(out);
+}
+
+bool LevelPackWriter::open(const std::string& path) {
+    if (out) fclose(out);
+    out = fopen(path.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Could not create level pack: " << path << std::endl;
+        return false;
+    }
+    offset = 0;
+    failed = false;
+    entries.clear();
+    
+    LevelPack::Header header = {};  // Completed by finish()
+    writeBytes(&header, sizeof(header));
+    return !failed;
+}
+
+void LevelPackWriter::writeBytes(const void* bytes, size_t size) {
+    if (size > 0 && fwrite(bytes, 1, size, out) != size) failed = true;
+    offset += size;
+}
+
+void LevelPackWriter::pad(size_t alignment) {
+    static const uint8_t zeros[8] = {};
+    writeBytes(zeros, alignUp(offset, alignment) - offset);
+}
+
+bool LevelPackWriter::add(const LevelKey& key, const Level* level) {
+    if (!out) return false;
+    
+    std::vector<LevelPack::Template> templates;
+    for (size_t i = 0; i < level->spriteTemplates.size(); i++) {
+        const SpriteTemplate* st = level->spriteTemplates[i];
+        if (st) templates.push_back({(uint32_t)i, (int16_t)st->type, (uint8_t)st->winged, 0});
+    }
+    
+    bool hasData = std::any_of(level->data.begin(), level->data.end(), [](uint8_t b) { return b != 0; });
+    
+    pad(8);
+    LevelPack::Entry entry = {key.seed, key.difficulty, key.type, offset, 0};
+    LevelPack::LevelHeader header = {level->width, level->height, level->xExit, level->yExit,
+                                     (uint32_t)templates.size(), hasData ? LevelPack::LEVEL_HAS_DATA : 0};
+    writeBytes(&header, sizeof(header));
+    writeBytes(level->map.data(), level->map.size());
+    if (hasData) writeBytes(level->data.data(), level->data.size());
+    pad(alignof(LevelPack::Template));
+    writeBytes(templates.data(), templates.size() * sizeof(LevelPack::Template));
+    entry.size = offset - entry.offset;
+    entries.push_back(entry);
+    return !failed;
+}
+
+bool LevelPackWriter::finish() {
+    if (!out) return false;
+    
+    // Stable, so the first level added for a key is the one kept
+    std::stable_sort(entries.begin(), entries.end(), [](const LevelPack::Entry& a, const LevelPack::Entry& b) {
+        return keyLess(a.key(), b.key());
+    });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const LevelPack::Entry& a, const LevelPack::Entry& b) { return a.key() == b.key(); }),
+                  entries.end());
+    
+    pad(8);
+    LevelPack::Header header = {LevelPack::MAGIC, LevelPack::VERSION, (uint32_t)entries.size(), 0, offset};
+    writeBytes(entries.data(), entries.size() * sizeof(LevelPack::Entry));
+    if (fseek(out, 0, SEEK_SET) != 0) failed = true;
+    writeBytes(&header, sizeof(header));
+    if (fclose(out) != 0) failed = true;
+    out = nullptr;
+    return !failed;
+}
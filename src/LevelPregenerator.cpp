@@ -0,0 +1,105 @@
+/**
+ * @file LevelPregenerator.cpp
+ * @brief Background level generation.
+ */
+#include "LevelPregenerator.h"
+#include "LevelCache.h"
+#include "BgRenderer.h"
+#include "Level.h"
+#include <algorithm>
+
+void PregeneratedLevel::destroy() {
+    delete level;
+    delete bgLevels[0];
+    delete bgLevels[1];
+    level = bgLevels[0] = bgLevels[1] = nullptr;
+}
+
+LevelPregenerator::LevelPregenerator(int width, int height)
+    : width(width), height(height) {
+    worker = std::thread(&LevelPregenerator::workerLoop, this);
+}
+
+LevelPregenerator::~LevelPregenerator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    wakeWorker.notify_one();
+    worker.join();
+    
+    for (auto& entry : ready) {
+        entry.second.destroy();
+    }
+}
+
+void LevelPregenerator::request(const std::vector<LevelKey>& keys) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    wanted = keys;
+    for (auto it = ready.begin(); it != ready.end();) {
+        if (std::find(keys.begin(), keys.end(), it->first) != keys.end()) {
+            ++it;
+        } else {
+            it->second.destroy();
+            it = ready.erase(it);
+        }
+    }
+    
+    queue.clear();
+    for (const auto& key : keys) {
+        bool done = std::any_of(ready.begin(), ready.end(),
+                                [&key](const auto& entry) { return entry.first == key; });
+        if (!done && !(building && current == key)) {
+            queue.push_back(key);
+        }
+    }
+    if (!queue.empty()) wakeWorker.notify_one();
+}
+
+bool LevelPregenerator::take(const LevelKey& key, PregeneratedLevel& out) {
+    std::unique_lock<std::mutex> lock(mutex);
+    levelFinished.wait(lock, [this, &key] { return !(building && current == key); });
+    
+    for (auto it = ready.begin(); it != ready.end(); ++it) {
+        if (it->first == key) {
+            out = it->second;
+            ready.erase(it);
+            return true;
+        }
+    }
+    // Not started yet: the caller builds it now, so don't build it twice
+    queue.erase(std::remove(queue.begin(), queue.end(), key), queue.end());
+    return false;
+}
+
+void LevelPregenerator::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeWorker.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        
+        current = queue.front();
+        queue.erase(queue.begin());
+        building = true;
+        LevelKey key = current;
+        lock.unlock();
+        
+        PregeneratedLevel built;
+        built.level = LevelCache::acquire(width, height, key.seed, key.difficulty, key.type);
+        built.bgLevels[0] = BgRenderer::generateBgLevel(BgRenderer::BG_WIDTH, height, true, key.type);
+        built.bgLevels[1] = BgRenderer::generateBgLevel(BgRenderer::BG_WIDTH, height, false, key.type);
+        DEBUG_PRINT("Pregenerated level seed=%lld difficulty=%d type=%d", (long long)key.seed, key.difficulty, key.type);
+        
+        lock.lock();
+        building = false;
+        // The map may have moved on while this one was being built
+        if (std::find(wanted.begin(), wanted.end(), key) != wanted.end()) {
+            ready.emplace_back(key, built);
+        } else {
+            built.destroy();
+        }
+        levelFinished.notify_all();
+    }
+}
@@ -4,6 +4,7 @@
  */
 #include "LevelRenderer.h"
 #include "Level.h"
+#include "TileTables.h"
 #include "Art.h"
 #include <cmath>
 
@@ -29,35 +30,16 @@ void LevelRenderer::render(SDL_Renderer* renderer, int tick, float alpha) {
             
             // Calculate bump Y offset
             int yo = 0;
-            if (x >= 0 && y >= 0 && x < level->width && y < level->height) {
-                int bumpData = level->data[x][y];
-                if (bumpData > 0) {
-                    yo = (int)(std::sin((bumpData - alpha) / 4.0f * 3.14159f) * 8);
-                }
+            int bumpData = level->getBlockData(x, y);
+            if (bumpData > 0) {
+                yo = (int)(std::sin((bumpData - alpha) / 4.0f * 3.14159f) * 8);
             }
             
-            // Tile coordinates: column = b % 16, row = b / 16
-            int xTile = b % 16;
+            // Tile coordinates: column = b % 16 (or the current frame of
+            // an animated tile), row = b / 16
+            int xTile = Level::TILE_TABLES.frameColumn(b, tick, x, y);
             int yTile = b / 16;
             
-            // Handle animated tiles
-            if ((Level::TILE_BEHAVIORS[b] & Level::BIT_ANIMATED) > 0) {
-                int animTime = (tick / 3) % 4;
-                
-                // Special animation for question blocks (column 0-3, row 1)
-                if ((b % 16) / 4 == 0 && b / 16 == 1) {
-                    animTime = (tick / 2 + (x + y) / 8) % 20;
-                    if (animTime > 3) animTime = 0;
-                }
-                // Used/empty blocks don't animate
-                if ((b % 16) / 4 == 3 && b / 16 == 0) {
-                    animTime = 2;
-                }
-                
-                // For animated tiles: column = (b % 16) / 4 * 4 + animTime
-                xTile = (b % 16) / 4 * 4 + animTime;
-            }
-            
             if (xTile < (int)Art::level.size() && yTile < (int)Art::level[xTile].size()) {
                 SDL_Rect dst = {x * 16 - xCam, y * 16 - yCam - yo, 16, 16};
                 SDL_RenderCopy(renderer, Art::level[xTile][yTile], nullptr, &dst);
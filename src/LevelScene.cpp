@@ -6,8 +6,10 @@
 #include "Game.h"
 #include "Art.h"
 #include "Level.h"
-#include "LevelGenerator.h"
+#include "LevelCache.h"
+#include "LevelStream.h"
 #include "LevelRenderer.h"
+#include "LevelValidator.h"
 #include "BgRenderer.h"
 #include "Mario.h"
 #include "Enemy.h"
@@ -21,11 +23,21 @@
 #include "Sparkle.h"
 #include "Particle.h"
 #include "SpriteTemplate.h"
+#include "SaveState.h"
+#include "TileTables.h"
 #include <algorithm>
 #include <cmath>
 
-LevelScene::LevelScene(Game* game, long seed, int levelDifficulty, int type)
-    : levelSeed(seed), levelDifficulty(levelDifficulty), levelType(type) {
+// Background levels repeat every BG_WIDTH columns at 1/4 and 1/2 of the
+// camera speed, so a rebase by a whole number of those periods does not
+// move the backgrounds
+static_assert(LevelScene::ENDLESS_REBASE_COLUMNS % LevelStream::RING_COLUMNS == 0,
+              "rebase must keep ring slots in place");
+static_assert(LevelScene::ENDLESS_REBASE_COLUMNS * 16 % (BgRenderer::BG_WIDTH * 32 * 4) == 0,
+              "rebase must keep the backgrounds in place");
+
+LevelScene::LevelScene(Game* game, int64_t seed, int levelDifficulty, int type, bool endless)
+    : random(seed), endless(endless), levelSeed(seed), levelDifficulty(levelDifficulty), levelType(type) {
     this->game = game;
 }
 
@@ -35,23 +47,49 @@ LevelScene::~LevelScene() {
     }
     sprites.clear();
     
-    delete level;
+    if (stream) {
+        delete stream;  // Owns level
+    } else {
+        delete level;
+    }
     delete layer;
     delete bgLayer[0];
     delete bgLayer[1];
+    delete adoptedBgLevels[0];
+    delete adoptedBgLevels[1];
+}
+
+void LevelScene::adoptLevel(Level* level, Level* bgDistant, Level* bgNear) {
+    this->level = level;
+    adoptedBgLevels[0] = bgDistant;
+    adoptedBgLevels[1] = bgNear;
 }
 
 void LevelScene::init() {
-    DEBUG_PRINT("LevelScene::init() seed=%ld difficulty=%d type=%d", levelSeed, levelDifficulty, levelType);
+    initLevel();
+    startLevelMusic();
+}
+
+void LevelScene::initLevel() {
+    DEBUG_PRINT("LevelScene::init() seed=%lld difficulty=%d type=%d", (long long)levelSeed, levelDifficulty, levelType);
     
-    level = LevelGenerator::createLevel(320, 15, levelSeed, levelDifficulty, levelType);
-    DEBUG_PRINT("  Level created: %dx%d", level->width, level->height);
+    if (endless) {
+        stream = new LevelStream(LEVEL_HEIGHT, levelSeed, levelDifficulty, levelType);
+        level = stream->getLevel();
+        stream->advance(SCREEN_WIDTH / 16 + ENDLESS_LOOKAHEAD, 0);
+    } else if (!level) {
+        level = LevelCache::acquire(levelWidth, LEVEL_HEIGHT, levelSeed, levelDifficulty, levelType);
+    }
+    DEBUG_PRINT("  Level created: %dx%d%s", level->width, level->height, endless ? " (endless ring)" : "");
+    if (g_debugMode && !endless) {
+        ValidationResult check = LevelValidator::validate(level, Mario::large);
+        if (!check.reachable) {
+            DEBUG_PRINT("  Exit at x=%d looks unreachable, stuck at (%d, %d)",
+                        level->xExit, check.stuckX, check.stuckY);
+        }
+    }
     
-    layer = new LevelRenderer(level, SCREEN_WIDTH, SCREEN_HEIGHT);
-    // Create two background layers with different scroll speeds (distance)
-    // Java: scrollSpeed = 4 >> i, so layer 0 has distance 4, layer 1 has distance 2
-    bgLayer[0] = new BgRenderer(SCREEN_WIDTH, SCREEN_HEIGHT, levelType, 4, true);   // distant
-    bgLayer[1] = new BgRenderer(SCREEN_WIDTH, SCREEN_HEIGHT, levelType, 2, false);  // near
+    createLayers();
     
     mario = new Mario(this);
     sprites.push_back(mario);
@@ -61,12 +99,34 @@ void LevelScene::init() {
     // Used for iris opening animation
     startTime = 1;
     
-    timeLeft = 200 * TICKS_PER_SECOND;
+    // 200 seconds per standard level width, within what the HUD can show
+    timeLeft = std::min(200 * std::max(1, level->width / LEVEL_WIDTH), 999) * TICKS_PER_SECOND;
     
-    // Start music based on level type (force restart from beginning)
     musicType = levelType;
-    if (levelType == 0) Art::startMusic(MUSIC_OVERWORLD, true);
-    else if (levelType == 1) Art::startMusic(MUSIC_UNDERGROUND, true);
+}
+
+void LevelScene::createLayers() {
+    layer = new LevelRenderer(level, SCREEN_WIDTH, SCREEN_HEIGHT);
+    createBgLayers();
+}
+
+void LevelScene::createBgLayers() {
+    // Create two background layers with different scroll speeds (distance)
+    // Java: scrollSpeed = 4 >> i, so layer 0 has distance 4, layer 1 has distance 2
+    if (adoptedBgLevels[0] && adoptedBgLevels[1]) {
+        bgLayer[0] = new BgRenderer(SCREEN_WIDTH, SCREEN_HEIGHT, levelType, 4, adoptedBgLevels[0]);
+        bgLayer[1] = new BgRenderer(SCREEN_WIDTH, SCREEN_HEIGHT, levelType, 2, adoptedBgLevels[1]);
+        adoptedBgLevels[0] = adoptedBgLevels[1] = nullptr;
+        return;
+    }
+    bgLayer[0] = new BgRenderer(SCREEN_WIDTH, SCREEN_HEIGHT, levelType, 4, true);   // distant
+    bgLayer[1] = new BgRenderer(SCREEN_WIDTH, SCREEN_HEIGHT, levelType, 2, false);  // near
+}
+
+void LevelScene::startLevelMusic() {
+    // Start music based on level type (force restart from beginning)
+    if (musicType == 0) Art::startMusic(MUSIC_OVERWORLD, true);
+    else if (musicType == 1) Art::startMusic(MUSIC_UNDERGROUND, true);
     else Art::startMusic(MUSIC_CASTLE, true);
 }
 
@@ -111,8 +171,8 @@ void LevelScene::tick() {
     
     level->tick();
     
-    // In test mode, time doesn't decrease
-    if (!g_testMode) {
+    // In test mode, time doesn't decrease; endless levels have no limit
+    if (!g_testMode && !endless) {
         timeLeft--;
         
         if (timeLeft == 0 && mario) {
@@ -129,11 +189,13 @@ void LevelScene::tick() {
     }
     
     // Clamp camera
-    if (xCam < 0) xCam = 0;
+    if (xCam < level->firstColumn * 16) xCam = level->firstColumn * 16;
     if (yCam < 0) yCam = 0;
-    if (xCam > level->width * 16 - SCREEN_WIDTH) xCam = level->width * 16 - SCREEN_WIDTH;
+    if (xCam > level->endColumn * 16 - SCREEN_WIDTH) xCam = level->endColumn * 16 - SCREEN_WIDTH;
     if (yCam > level->height * 16 - SCREEN_HEIGHT) yCam = level->height * 16 - SCREEN_HEIGHT;
     
+    if (stream) updateStream();
+    
     // Spawn enemies from templates and check for cannons
     for (int x = (int)xCam / 16 - 1; x <= (int)(xCam + SCREEN_WIDTH) / 16 + 1; x++) {
         for (int y = (int)yCam / 16 - 1; y <= (int)(yCam + SCREEN_HEIGHT) / 16 + 1; y++) {
@@ -163,25 +225,19 @@ void LevelScene::tick() {
                     st->spawn(this, x, y, dir);
                 }
             }
-            if (st) st->lastVisibleTick = tickCount;
+            if (st) level->markTemplateSeen(st, tickCount);
             
             // Check for cannon blocks and spawn BulletBills
-            if (dir != 0) {
-                uint8_t b = level->getBlock(x, y);
-                if ((Level::TILE_BEHAVIORS[b & 0xff] & Level::BIT_ANIMATED) > 0) {
-                    // Check if it's a cannon block (column 12-15, row 0)
-                    if ((b % 16) / 4 == 3 && b / 16 == 0) {
-                        if ((tickCount - x * 2) % 100 == 0) {
-                            // Spawn sparkles
-                            for (int i = 0; i < 8; i++) {
-                                addSprite(new Sparkle(x * 16 + 8, y * 16 + rand() % 16,
-                                                      (float)(rand() % 100) / 100.0f * dir, 0, 0, 1, 5));
-                            }
-                            // Spawn BulletBill
-                            addSprite(new BulletBill(this, x * 16 + 8 + dir * 8, y * 16 + 15, dir));
-                            Art::playSound(SAMPLE_CANNON_FIRE);
-                        }
+            if (dir != 0 && Level::TILE_TABLES.cannon[level->getBlock(x, y)]) {
+                if ((tickCount - x * 2) % 100 == 0) {
+                    // Spawn sparkles
+                    for (int i = 0; i < 8; i++) {
+                        addSprite(new Sparkle(this, x * 16 + 8, y * 16 + random.nextInt(16),
+                                              (float)(random.nextInt(100)) / 100.0f * dir, 0, 0, 1, 5));
                     }
+                    // Spawn BulletBill
+                    addSprite(new BulletBill(this, x * 16 + 8 + dir * 8, y * 16 + 15, dir));
+                    Art::playSound(SAMPLE_CANNON_FIRE);
                 }
             }
         }
@@ -268,6 +324,11 @@ void LevelScene::tick() {
         if (it != sprites.end()) {
             sprites.erase(it);
             if (sprite != mario) {
+                // Let the template respawn the sprite instead of keeping
+                // a dangling pointer to it
+                if (sprite->spriteTemplate && sprite->spriteTemplate->sprite == sprite) {
+                    sprite->spriteTemplate->sprite = nullptr;
+                }
                 delete sprite;
             }
         }
@@ -287,9 +348,9 @@ void LevelScene::render(SDL_Renderer* renderer, float alpha) {
     }
     
     // Clamp camera
-    if (xCamLerp < 0) xCamLerp = 0;
+    if (xCamLerp < level->firstColumn * 16) xCamLerp = level->firstColumn * 16;
     if (yCamLerp < 0) yCamLerp = 0;
-    if (xCamLerp > level->width * 16 - SCREEN_WIDTH) xCamLerp = level->width * 16 - SCREEN_WIDTH;
+    if (xCamLerp > level->endColumn * 16 - SCREEN_WIDTH) xCamLerp = level->endColumn * 16 - SCREEN_WIDTH;
     if (yCamLerp > level->height * 16 - SCREEN_HEIGHT) yCamLerp = level->height * 16 - SCREEN_HEIGHT;
     
     // Render backgrounds (order: far layer first, then near)
@@ -329,7 +390,7 @@ void LevelScene::render(SDL_Renderer* renderer, float alpha) {
     }
     
     // Render exit (back part - left pole)
-    if (layer) {
+    if (layer && !endless) {
         layer->renderExit0(renderer, tickCount, alpha, mario == nullptr || mario->winTime == 0);
     }
     
@@ -391,7 +452,7 @@ void LevelScene::render(SDL_Renderer* renderer, float alpha) {
     }
     
     // Render exit (front part - right pole)
-    if (layer) {
+    if (layer && !endless) {
         layer->renderExit1(renderer, tickCount, alpha);
     }
     
@@ -415,12 +476,19 @@ void LevelScene::render(SDL_Renderer* renderer, float alpha) {
     Art::drawString("WORLD", 24 * 8, 0 * 8, 7);
     Art::drawString(" " + Mario::levelString, 24 * 8, 1 * 8, 7);
     
-    // TIME at col 35
-    int seconds = timeLeft / TICKS_PER_SECOND;
-    if (seconds < 0) seconds = 0;
-    Art::drawString("TIME", 35 * 8, 0 * 8, 7);
-    snprintf(buf, sizeof(buf), " %03d", seconds);
-    Art::drawString(buf, 35 * 8, 1 * 8, 7);
+    if (endless) {
+        // Distance in columns at col 33 (endless levels have no timer)
+        Art::drawString("DIST", 33 * 8, 0 * 8, 7);
+        snprintf(buf, sizeof(buf), "%07lld", (long long)std::min<int64_t>(endlessDistance(), 9999999));
+        Art::drawString(buf, 33 * 8, 1 * 8, 7);
+    } else {
+        // TIME at col 35
+        int seconds = timeLeft / TICKS_PER_SECOND;
+        if (seconds < 0) seconds = 0;
+        Art::drawString("TIME", 35 * 8, 0 * 8, 7);
+        snprintf(buf, sizeof(buf), " %03d", seconds);
+        Art::drawString(buf, 35 * 8, 1 * 8, 7);
+    }
     
     // Draw PAUSE text centered on screen
     if (userPaused) {
@@ -453,6 +521,53 @@ void LevelScene::render(SDL_Renderer* renderer, float alpha) {
     }
 }
 
+int64_t LevelScene::endlessDistance() const {
+    if (!stream || !mario) return 0;
+    return stream->shiftedColumns() + (int64_t)(mario->x / 16);
+}
+
+// Keep the built columns ahead of the camera and retire the ones far
+// behind it
+void LevelScene::updateStream() {
+    if (level->firstColumn >= ENDLESS_REBASE_COLUMNS) rebase(ENDLESS_REBASE_COLUMNS);
+    
+    int xCamColumn = (int)xCam / 16;
+    int xKeep = xCamColumn - ENDLESS_KEEP_BEHIND;
+    if (xKeep > level->firstColumn) {
+        // Sprites spawned from retired templates (a carried shell, say)
+        // must not write to the slots once new templates take them over
+        std::vector<Sprite*>* lists[] = {&sprites, &spritesToAdd};
+        for (int x = level->firstColumn; x < xKeep; x++) {
+            for (int y = 0; y < level->height; y++) {
+                SpriteTemplate* st = level->getSpriteTemplate(x, y);
+                if (!st) continue;
+                for (auto* list : lists) {
+                    for (auto* sprite : *list) {
+                        if (sprite->spriteTemplate == st) sprite->spriteTemplate = nullptr;
+                    }
+                }
+            }
+        }
+    }
+    stream->advance(xCamColumn + SCREEN_WIDTH / 16 + ENDLESS_LOOKAHEAD, xKeep);
+}
+
+// Move the level and everything in it `columns` to the left
+void LevelScene::rebase(int columns) {
+    DEBUG_PRINT("Rebasing endless level by %d columns", columns);
+    stream->shift(columns);
+    float dx = columns * 16.0f;
+    for (auto* list : {&sprites, &spritesToAdd}) {
+        for (auto* sprite : *list) {
+            sprite->x -= dx;
+            sprite->xOld -= dx;
+        }
+    }
+    if (mario) mario->xDeathPos -= columns * 16;
+    xCam -= dx;
+    xCamO -= dx;
+}
+
 void LevelScene::addSprite(Sprite* sprite) {
     sprite->spriteContext = this;
     spritesToAdd.push_back(sprite);
@@ -492,7 +607,7 @@ void LevelScene::bump(int x, int y, bool canBreakBricks) {
             
             for (int xx = 0; xx < 2; xx++) {
                 for (int yy = 0; yy < 2; yy++) {
-                    addSprite(new Particle(x * 16 + xx * 8 + 4, y * 16 + yy * 8 + 4,
+                    addSprite(new Particle(this, x * 16 + xx * 8 + 4, y * 16 + yy * 8 + 4,
                                           (xx * 2 - 1) * 4.0f, (yy * 2 - 1) * 4.0f - 8));
                 }
             }
@@ -645,11 +760,7 @@ void LevelScene::handlePauseKey() {
     DEBUG_PRINT("Game %s", userPaused ? "PAUSED" : "RESUMED");
     
     // Pause/resume music
-    if (userPaused) {
-        Mix_PauseMusic();
-    } else {
-        Mix_ResumeMusic();
-    }
+    Art::pauseMusic(userPaused);
 }
 
 /**
@@ -803,3 +914,306 @@ void LevelScene::convertEnemiesToCoins() {
         removeSprite(sprite);
     }
 }
+
+// ============================================================================
+// SAVESTATES
+// ============================================================================
+
+/**
+ * Construct an empty sprite of the given kind for readState() to fill in.
+ * Constructor arguments are placeholders; every field they set is
+ * overwritten from the savestate.
+ */
+static Sprite* createSpriteOfKind(LevelScene* world, SpriteKind kind) {
+    switch (kind) {
+        case SpriteKind::ENEMY:        return new Enemy(world, 0, 0, 1, Enemy::ENEMY_GOOMBA, false);
+        case SpriteKind::FLOWER_ENEMY: return new FlowerEnemy(world, 0, 0);
+        case SpriteKind::SHELL:        return new Shell(world, 0, 0, 0);
+        case SpriteKind::FIREBALL:     return new Fireball(world, 0, 0, 1);
+        case SpriteKind::BULLET_BILL:  return new BulletBill(world, 0, 0, 1);
+        case SpriteKind::MUSHROOM:     return new Mushroom(world, 0, 0);
+        case SpriteKind::FIRE_FLOWER:  return new FireFlower(world, 0, 0);
+        case SpriteKind::PARTICLE:     return new Particle(0, 0, 0, 0, 0, 0);
+        case SpriteKind::SPARKLE:      return new Sparkle(world, 0, 0, 0, 0, 0, 0, 1);
+        case SpriteKind::COIN_ANIM:    return new CoinAnim(0, 0);
+        default:                       return nullptr;
+    }
+}
+
+/**
+ * Serialize the whole scene. Sprites are written in tick order (live
+ * list, then pending adds); pointers between objects (template <-> sprite,
+ * Mario's carried shell) are stored as indices into that order.
+ * Mario is written up front because other sprites' constructors
+ * (FlowerEnemy) look at him.
+ */
+void LevelScene::writeState(StateWriter& out) const {
+    writeLevelState(out);
+    writeDynamicState(out);
+}
+
+bool LevelScene::readState(StateReader& in) {
+    bool fresh = (level == nullptr);
+    if (!readLevelState(in) || !readDynamicState(in)) return false;
+    if (fresh) startLevelMusic();
+    return true;
+}
+
+void LevelScene::writeLevelState(StateWriter& out) const {
+    out.write<int64_t>(levelSeed);
+    out.write<int32_t>(levelDifficulty);
+    out.write<int32_t>(levelType);
+    level->writeState(out);
+}
+
+void LevelScene::writeDynamicState(StateWriter& out) const {
+    std::vector<Sprite*> all(sprites);
+    all.insert(all.end(), spritesToAdd.begin(), spritesToAdd.end());
+    
+    uint32_t templateCount = 0;
+    for (auto* st : level->spriteTemplates) {
+        if (st) templateCount++;
+    }
+    out.write<uint32_t>(templateCount);
+    for (size_t i = 0; i < level->spriteTemplates.size(); i++) {
+        const SpriteTemplate* st = level->spriteTemplates[i];
+        if (!st) continue;
+        out.write<uint32_t>((uint32_t)i);
+        out.write<int32_t>(st->type);
+        out.write(st->winged);
+        out.write(st->isDead);
+        out.write<int32_t>(st->lastVisibleTick);
+        out.write<int32_t>(indexOfSprite(all, st->sprite));
+    }
+    writeSpriteState(out, all);
+}
+
+/**
+ * Rewind frames keep the level and its templates in place (their
+ * changes are undone through Level::editLog), so only the templates
+ * linked to a live sprite are written, found from the sprites.
+ */
+void LevelScene::writeRewindState(StateWriter& out) const {
+    std::vector<Sprite*> all(sprites);
+    all.insert(all.end(), spritesToAdd.begin(), spritesToAdd.end());
+    
+    uint32_t linkCount = 0;
+    for (auto* sprite : all) {
+        if (sprite->spriteTemplate && sprite->spriteTemplate->sprite == sprite) linkCount++;
+    }
+    out.write<uint32_t>(linkCount);
+    for (size_t i = 0; i < all.size(); i++) {
+        const SpriteTemplate* st = all[i]->spriteTemplate;
+        if (!st || st->sprite != all[i]) continue;
+        out.write<uint32_t>(st->cell);
+        out.write<int32_t>((int32_t)i);
+    }
+    writeSpriteState(out, all);
+}
+
+int32_t LevelScene::indexOfSprite(const std::vector<Sprite*>& all, const Sprite* sprite) {
+    if (!sprite) return -1;
+    auto it = std::find(all.begin(), all.end(), sprite);
+    return it == all.end() ? -1 : (int32_t)(it - all.begin());
+}
+
+void LevelScene::writeSpriteState(StateWriter& out, const std::vector<Sprite*>& all) const {
+    // Cross-level state lives in Mario's statics
+    out.write(Mario::large);
+    out.write(Mario::fire);
+    out.write<int32_t>(Mario::coins);
+    out.write<int32_t>(Mario::lives);
+    out.write<int32_t>(Mario::score);
+    out.writeString(Mario::levelString);
+    
+    mario->writeState(out);
+    out.write<int32_t>(indexOfSprite(all, mario->carried));
+    
+    // Template slot of each sprite, keyed by grid index
+    out.write<uint32_t>((uint32_t)sprites.size());
+    out.write<uint32_t>((uint32_t)spritesToAdd.size());
+    for (auto* sprite : all) {
+        out.write<uint8_t>((uint8_t)sprite->getKind());
+        if (sprite == mario) continue;
+        out.write<int32_t>(sprite->spriteTemplate ? (int32_t)sprite->spriteTemplate->cell : -1);
+        sprite->writeState(out);
+    }
+    
+    out.write(xCam);
+    out.write(yCam);
+    out.write(xCamO);
+    out.write(yCamO);
+    out.write(paused);
+    out.write(userPaused);
+    out.write<int32_t>(startTime);
+    out.write<int32_t>(timeLeft);
+    out.write<int32_t>(fireballsOnScreen);
+    out.write<int32_t>(tickCount);
+    out.write<int32_t>(musicType);
+    out.write<int64_t>(random.getState());
+}
+
+void LevelScene::clearSprites() {
+    for (auto* sprite : spritesToAdd) {
+        if (std::find(sprites.begin(), sprites.end(), sprite) == sprites.end()) {
+            sprites.push_back(sprite);
+        }
+    }
+    for (auto* sprite : sprites) {
+        if (sprite->spriteTemplate && sprite->spriteTemplate->sprite == sprite) {
+            sprite->spriteTemplate->sprite = nullptr;
+        }
+        delete sprite;
+    }
+    sprites.clear();
+    spritesToAdd.clear();
+    spritesToRemove.clear();
+    mario = nullptr;
+}
+
+void LevelScene::clearState() {
+    clearSprites();
+    delete level;
+    level = nullptr;
+}
+
+bool LevelScene::readLevelState(StateReader& in) {
+    int oldType = levelType;
+    clearState();
+    
+    levelSeed = in.read<int64_t>();
+    levelDifficulty = in.read<int32_t>();
+    levelType = in.read<int32_t>();
+    level = Level::readState(in);
+    if (!level) return false;
+    
+    if (layer) {
+        layer->setLevel(level);
+    } else {
+        layer = new LevelRenderer(level, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+    // Backgrounds only depend on the level type, so keep them across rewinds
+    if (!bgLayer[0] || levelType != oldType) {
+        delete bgLayer[0];
+        delete bgLayer[1];
+        createBgLayers();
+    }
+    return true;
+}
+
+bool LevelScene::readDynamicState(StateReader& in) {
+    uint32_t templateCount = in.read<uint32_t>();
+    if (templateCount > level->spriteTemplates.size()) return false;
+    TemplateLinks templateSprites;
+    for (uint32_t i = 0; i < templateCount; i++) {
+        uint32_t slot = in.read<uint32_t>();
+        int type = in.read<int32_t>();
+        bool winged = in.readBool();
+        if (!in.good() || slot >= level->spriteTemplates.size() || level->spriteTemplates[slot]) {
+            return false;
+        }
+        SpriteTemplate* st = level->addSpriteTemplate(slot / level->height, slot % level->height, type, winged);
+        st->isDead = in.readBool();
+        st->lastVisibleTick = in.read<int32_t>();
+        templateSprites.emplace_back(st, in.read<int32_t>());
+    }
+    return readSpriteState(in, templateSprites);
+}
+
+bool LevelScene::readRewindState(StateReader& in) {
+    clearSprites();
+    uint32_t linkCount = in.read<uint32_t>();
+    if (!in.good() || linkCount > in.remaining()) return false;
+    TemplateLinks links;
+    for (uint32_t i = 0; i < linkCount; i++) {
+        uint32_t cell = in.read<uint32_t>();
+        int32_t index = in.read<int32_t>();
+        if (!in.good() || cell >= level->spriteTemplates.size() || !level->spriteTemplates[cell]) {
+            return false;
+        }
+        links.emplace_back(level->spriteTemplates[cell], index);
+    }
+    return readSpriteState(in, links);
+}
+
+bool LevelScene::readSpriteState(StateReader& in, const TemplateLinks& templateSprites) {
+    Mario::large = in.readBool();
+    Mario::fire = in.readBool();
+    Mario::coins = in.read<int32_t>();
+    Mario::lives = in.read<int32_t>();
+    Mario::score = in.read<int32_t>();
+    Mario::levelString = in.readString();
+    
+    mario = new Mario(this);
+    mario->spriteContext = this;
+    mario->readState(in);
+    int32_t carriedIndex = in.read<int32_t>();
+    
+    uint32_t liveCount = in.read<uint32_t>();
+    uint32_t pendingCount = in.read<uint32_t>();
+    
+    // The destructor only owns the live list, so drop anything else here
+    auto fail = [this]() {
+        bool marioLive = std::find(sprites.begin(), sprites.end(), mario) != sprites.end();
+        for (auto* sprite : spritesToAdd) {
+            if (sprite != mario) delete sprite;
+        }
+        spritesToAdd.clear();
+        if (!marioLive) delete mario;
+        mario = nullptr;
+        return false;
+    };
+    
+    // Every sprite costs at least its kind byte, so this bounds the counts
+    if (!in.good() || (uint64_t)liveCount + pendingCount > in.remaining()) {
+        return fail();
+    }
+    
+    std::vector<Sprite*> all;
+    bool marioPlaced = false;
+    for (uint32_t i = 0; i < liveCount + pendingCount; i++) {
+        SpriteKind kind = (SpriteKind)in.read<uint8_t>();
+        Sprite* sprite;
+        if (kind == SpriteKind::MARIO) {
+            if (marioPlaced) return fail();
+            sprite = mario;
+            marioPlaced = true;
+        } else {
+            int32_t slot = in.read<int32_t>();
+            sprite = createSpriteOfKind(this, kind);
+            if (!sprite) return fail();
+            sprite->spriteContext = this;
+            sprite->readState(in);
+            if (slot >= 0 && slot < (int32_t)level->spriteTemplates.size()) {
+                sprite->spriteTemplate = level->spriteTemplates[slot];
+            }
+        }
+        all.push_back(sprite);
+        (i < liveCount ? sprites : spritesToAdd).push_back(sprite);
+        if (!in.good()) return fail();
+    }
+    if (!marioPlaced) return fail();
+    
+    auto spriteAt = [&all](int32_t index) -> Sprite* {
+        return index >= 0 && index < (int32_t)all.size() ? all[index] : nullptr;
+    };
+    for (auto& entry : templateSprites) {
+        entry.first->sprite = spriteAt(entry.second);
+    }
+    mario->carried = spriteAt(carriedIndex);
+    
+    xCam = in.read<float>();
+    yCam = in.read<float>();
+    xCamO = in.read<float>();
+    yCamO = in.read<float>();
+    paused = in.readBool();
+    userPaused = in.readBool();
+    startTime = in.read<int32_t>();
+    timeLeft = in.read<int32_t>();
+    fireballsOnScreen = in.read<int32_t>();
+    tickCount = in.read<int32_t>();
+    musicType = in.read<int32_t>();
+    random.setState(in.read<int64_t>());
+    if (!in.good()) return fail();
+    return true;
+}
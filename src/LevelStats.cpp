@@ -0,0 +1,235 @@
+/**
+ * @file LevelStats.cpp
+ * @brief Level statistics and the --stats tool mode.
+ */
+#include "LevelStats.h"
+#include "Level.h"
+#include "LevelGenerator.h"
+#include "LevelScene.h"
+#include "Enemy.h"
+#include "Autotiler.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Tiles as placed by LevelGenerator (autotiling only rewrites ground)
+static const uint8_t TILE_BRICK = 0 + 1 * 16;
+static const uint8_t TILE_HIDDEN_COIN = 1 + 1 * 16;
+static const uint8_t TILE_HIDDEN_POWERUP = 2 + 1 * 16;
+static const uint8_t TILE_QUESTION_COIN = 4 + 1 + 1 * 16;
+static const uint8_t TILE_QUESTION_POWERUP = 4 + 2 + 1 * 16;
+static const uint8_t TILE_COIN = 2 + 2 * 16;
+static const uint8_t TILE_TUBE_TOP = 10 + 0 * 16;   // Left half
+static const uint8_t TILE_CANNON_TOP = 14 + 0 * 16;
+
+LevelStats LevelStats::measure(const Level* level) {
+    LevelStats stats;
+    stats.addColumns(level, 0, level->width);
+    stats.finish();
+    return stats;
+}
+
+void LevelStats::addColumns(const Level* level, int x0, int x1) {
+    const int height = level->height;
+    width = level->width;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, level->width);
+    if (x0 >= x1) return;
+    
+    // Columns are contiguous in the flat arrays, so a column range is
+    // one run of tiles
+    size_t begin = (size_t)x0 * height;
+    size_t end = (size_t)x1 * height;
+    uint32_t histogram[256] = {};
+    for (size_t i = begin; i < end; i++) {
+        histogram[level->map[i]]++;
+    }
+    cannons += histogram[TILE_CANNON_TOP];
+    tubes += histogram[TILE_TUBE_TOP];
+    coins += histogram[TILE_COIN];
+    questionBlocks += histogram[TILE_QUESTION_COIN] + histogram[TILE_QUESTION_POWERUP];
+    hiddenBlocks += histogram[TILE_HIDDEN_COIN] + histogram[TILE_HIDDEN_POWERUP];
+    bricks += histogram[TILE_BRICK];
+    
+    for (size_t i = begin; i < end; i++) {
+        const SpriteTemplate* st = level->spriteTemplates[i];
+        if (!st || st->type < 0 || st->type > Enemy::ENEMY_FLOWER) continue;
+        enemies[st->type]++;
+        if (st->winged) winged++;
+    }
+    
+    // Ground always reaches the bottom row, so a column is part of a gap
+    // exactly when its bottom tile is not ground
+    for (int x = x0; x < x1; x++) {
+        const uint8_t* column = &level->map[x * height];
+        if (!Autotiler::isGround(column[height - 1])) {
+            gapRun++;
+            continue;
+        }
+        if (gapRun > 0) {
+            gaps++;
+            gapMaxWidth = std::max(gapMaxWidth, gapRun);
+            gapTotal += gapRun;
+            gapRun = 0;
+        }
+        
+        int top = height - 1;
+        while (top > 0 && Autotiler::isGround(column[top - 1])) {
+            top--;
+        }
+        int floorHeight = height - top;
+        floorSum += floorHeight;
+        floorSquares += (double)floorHeight * floorHeight;
+        groundColumns++;
+    }
+}
+
+void LevelStats::finish() {
+    if (gapRun > 0) {
+        gaps++;
+        gapMaxWidth = std::max(gapMaxWidth, gapRun);
+        gapTotal += gapRun;
+        gapRun = 0;
+    }
+    if (gaps > 0) gapMeanWidth = (float)gapTotal / gaps;
+    if (groundColumns > 0) {
+        double mean = floorSum / groundColumns;
+        floorMean = (float)mean;
+        floorVariance = (float)(floorSquares / groundColumns - mean * mean);
+    }
+}
+
+void LevelStats::collect(int64_t firstSeed, int64_t count, int difficulty, int threads, FILE* out) {
+    static const int TYPES = 3;
+    static const int CHUNK = 1024;  // Seeds per batch; rows are written between batches
+    
+    if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    
+    writeCsvHeader(out);
+    std::vector<LevelStats> rows;
+    for (int64_t done = 0; done < count; ) {
+        int seeds = (int)std::min<int64_t>(CHUNK, count - done);
+        size_t jobs = (size_t)seeds * TYPES;
+        rows.assign(jobs, LevelStats());
+        
+        std::atomic<size_t> next(0);
+        auto work = [&]() {
+            Level level(LevelScene::LEVEL_WIDTH, LevelScene::LEVEL_HEIGHT);
+            for (size_t i = next++; i < jobs; i = next++) {
+                // Seeds wrap past INT64_MAX like MapScene::levelSeedAt
+                int64_t seed = (int64_t)((uint64_t)firstSeed + (uint64_t)(done + (int64_t)(i / TYPES)));
+                int type = (int)(i % TYPES);
+                LevelGenerator::generateInto(&level, seed, difficulty, type);
+                rows[i] = measure(&level);
+                rows[i].seed = seed;
+                rows[i].type = type;
+                rows[i].difficulty = difficulty;
+            }
+        };
+        
+        std::vector<std::thread> pool;
+        for (int t = 1; t < std::min<int>(threads, (int)jobs); t++) {
+            pool.emplace_back(work);
+        }
+        work();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        
+        for (const LevelStats& row : rows) {
+            row.writeCsv(out);
+        }
+        done += seeds;
+    }
+    fflush(out);
+}
+
+struct StatField {
+    const char* name;
+    bool integer;
+    bool grows;         ///< Never decreases as columns are added
+    bool needsSprites;
+    double (*get)(const LevelStats& stats);
+};
+
+static double wingedRatio(const LevelStats& stats) {
+    int walkers = stats.enemies[Enemy::ENEMY_RED_KOOPA] + stats.enemies[Enemy::ENEMY_GREEN_KOOPA] +
+                  stats.enemies[Enemy::ENEMY_GOOMBA] + stats.enemies[Enemy::ENEMY_SPIKY];
+    return walkers > 0 ? (float)stats.winged / walkers : 0.0f;
+}
+
+static const StatField FIELDS[] = {
+    {"seed", true, false, false, [](const LevelStats& s) { return (double)s.seed; }},
+    {"type", true, false, false, [](const LevelStats& s) { return (double)s.type; }},
+    {"difficulty", true, false, false, [](const LevelStats& s) { return (double)s.difficulty; }},
+    {"gaps", true, true, false, [](const LevelStats& s) { return (double)s.gaps; }},
+    {"gap_max_width", true, true, false, [](const LevelStats& s) { return (double)s.gapMaxWidth; }},
+    {"gap_mean_width", false, false, false, [](const LevelStats& s) { return (double)s.gapMeanWidth; }},
+    {"red_koopas", true, true, true, [](const LevelStats& s) { return (double)s.enemies[Enemy::ENEMY_RED_KOOPA]; }},
+    {"green_koopas", true, true, true, [](const LevelStats& s) { return (double)s.enemies[Enemy::ENEMY_GREEN_KOOPA]; }},
+    {"goombas", true, true, true, [](const LevelStats& s) { return (double)s.enemies[Enemy::ENEMY_GOOMBA]; }},
+    {"spikies", true, true, true, [](const LevelStats& s) { return (double)s.enemies[Enemy::ENEMY_SPIKY]; }},
+    {"flowers", true, true, true, [](const LevelStats& s) { return (double)s.enemies[Enemy::ENEMY_FLOWER]; }},
+    {"winged_ratio", false, false, true, wingedRatio},
+    {"cannons", true, true, false, [](const LevelStats& s) { return (double)s.cannons; }},
+    {"cannons_per_100_columns", false, true, false,
+     [](const LevelStats& s) { return s.width > 0 ? (double)(s.cannons * 100.0f / s.width) : 0.0; }},
+    {"tubes", true, true, false, [](const LevelStats& s) { return (double)s.tubes; }},
+    {"coins", true, true, false, [](const LevelStats& s) { return (double)s.coins; }},
+    {"question_blocks", true, true, false, [](const LevelStats& s) { return (double)s.questionBlocks; }},
+    {"hidden_blocks", true, true, false, [](const LevelStats& s) { return (double)s.hiddenBlocks; }},
+    {"bricks", true, true, false, [](const LevelStats& s) { return (double)s.bricks; }},
+    {"floor_mean", false, false, false, [](const LevelStats& s) { return (double)s.floorMean; }},
+    {"floor_variance", false, false, false, [](const LevelStats& s) { return (double)s.floorVariance; }},
+};
+
+static const int FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+int LevelStats::fieldCount() {
+    return FIELD_COUNT;
+}
+
+const char* LevelStats::fieldName(int field) {
+    return FIELDS[field].name;
+}
+
+int LevelStats::findField(const std::string& name) {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (name == FIELDS[i].name) return i;
+    }
+    return -1;
+}
+
+bool LevelStats::fieldGrows(int field) {
+    return FIELDS[field].grows;
+}
+
+bool LevelStats::fieldNeedsSprites(int field) {
+    return FIELDS[field].needsSprites;
+}
+
+double LevelStats::field(int field) const {
+    return FIELDS[field].get(*this);
+}
+
+void LevelStats::writeCsvHeader(FILE* out) {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        fprintf(out, i > 0 ? ",%s" : "%s", FIELDS[i].name);
+    }
+    fputc('\n', out);
+}
+
+void LevelStats::writeCsv(FILE* out) const {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (i > 0) fputc(',', out);
+        if (i == 0) {
+            // The seed column; a double cannot hold every 64-bit seed
+            fprintf(out, "%lld", (long long)seed);
+        } else if (FIELDS[i].integer) {
+            fprintf(out, "%lld", (long long)FIELDS[i].get(*this));
+        } else {
+            fprintf(out, "%.3f", FIELDS[i].get(*this));
+        }
+    }
+    fputc('\n', out);
+}
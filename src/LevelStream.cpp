@@ -0,0 +1,60 @@
+/**
+ * @file LevelStream.cpp
+ * @brief Endless level stream implementation.
+ */
+#include "LevelStream.h"
+#include "Level.h"
+#include "Autotiler.h"
+#include <algorithm>
+#include <climits>
+
+static_assert(LevelStream::RING_COLUMNS > 2 * LevelStream::MAX_ZONE_LENGTH,
+              "ring must hold more than a couple of zones");
+
+LevelStream::LevelStream(int height, int64_t seed, int difficulty, int type) : type(type) {
+    level = new Level(RING_COLUMNS, height);
+    level->wrapColumns = true;
+    generator.start(level, seed, difficulty, type, true);
+    
+    // There is no exit to reach
+    level->xExit = INT_MAX / 32;
+    level->yExit = height - 1;
+    
+    level->endColumn = generator.buildStraight(0, MAX_ZONE_LENGTH, true);
+    finishColumns(0, level->endColumn);
+}
+
+LevelStream::~LevelStream() {
+    delete level;
+}
+
+void LevelStream::advance(int xNeeded, int xKeep) {
+    xKeep = std::min(xKeep, level->endColumn);
+    if (xKeep > level->firstColumn) {
+        level->clearColumns(level->firstColumn, xKeep);
+        level->firstColumn = xKeep;
+    }
+    
+    // One empty column always separates the newest column from the
+    // oldest, so nothing reads across the seam of the ring
+    int last = level->firstColumn + RING_COLUMNS - 1 - MAX_ZONE_LENGTH;
+    while (level->endColumn < xNeeded && level->endColumn <= last) {
+        int x0 = level->endColumn;
+        level->endColumn += generator.buildZone(x0, MAX_ZONE_LENGTH);
+        finishColumns(x0, level->endColumn);
+    }
+}
+
+void LevelStream::shift(int columns) {
+    level->firstColumn -= columns;
+    level->endColumn -= columns;
+    shifted += columns;
+}
+
+// Ceiling and ground tiles for newly built columns
+void LevelStream::finishColumns(int x0, int x1) {
+    if (type == LevelGenerator::TYPE_CASTLE || type == LevelGenerator::TYPE_UNDERGROUND) {
+        generator.buildCeiling(x0, x1);
+    }
+    Autotiler::apply(level, type, x0, x1);
+}
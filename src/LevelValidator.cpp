@@ -0,0 +1,313 @@
+/**
+ * @file LevelValidator.cpp
+ * @brief Level reachability search.
+ */
+#include "LevelValidator.h"
+#include "Level.h"
+#include "TileTables.h"
+#include "Mario.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+// One tile-level position along a jump arc, relative to the take-off
+// cell. Consecutive samples that touch the same tiles are merged.
+struct ArcStep {
+    int8_t x0, x1;    ///< Columns covered by the body
+    int8_t y0, y1;    ///< Rows covered by the body (y1 holds the feet)
+    bool rising;
+    bool landing;     ///< Feet entered row y1 from above
+    
+    bool operator==(const ArcStep& other) const {
+        return x0 == other.x0 && x1 == other.x1 && y0 == other.y0 && y1 == other.y1 &&
+               rising == other.rising && landing == other.landing;
+    }
+};
+
+// All arcs are merged into one prefix tree, so the steps they share
+// (every hold length starts the same way) are checked once per cell.
+struct ArcNode {
+    ArcStep step;
+    int firstChild = -1;
+    int nextSibling = -1;
+};
+
+typedef std::vector<ArcNode> ArcTree;  // Node 0 is the take-off cell
+
+static const int ARC_MAX_TICKS = 64;
+static const int ARC_MAX_DROP = 16;  // Rows below take-off before giving up
+
+static int tileOf(float pixel) {
+    return (int)std::floor(pixel / 16.0f);
+}
+
+// Replay Mario::move in open space and add the path to the tree: jump
+// held for `holdTicks` ticks, horizontal input `accel` (signed) from
+// tick `steerTick` on, starting at speed `xa`. Mario starts centred in
+// the take-off cell with his feet on its floor.
+static void addArc(ArcTree& tree, int holdTicks, float xa, float accel, int steerTick, int bodyHeight) {
+    float x = 8;
+    float y = 15;
+    float ya = 0;
+    int jumpTime = 0;
+    int footRow = 0;
+    int node = 0;
+    ArcStep last = tree[0].step;
+    
+    for (int tick = 0; tick < ARC_MAX_TICKS && footRow < ARC_MAX_DROP; tick++) {
+        if (tick == 0) {
+            jumpTime = Mario::JUMP_TIME;
+            ya = jumpTime * Mario::JUMP_SPEED;
+        } else if (tick < holdTicks && jumpTime > 0) {
+            ya = jumpTime * Mario::JUMP_SPEED;
+            jumpTime--;
+        } else {
+            jumpTime = 0;
+        }
+        if (tick >= steerTick) xa += accel;
+        if (std::fabs(xa) < 0.5f) xa = 0;
+        
+        // Sample the move in steps of at most 4 pixels so no tile is
+        // skipped (Mario::moveImpl collides in steps of 8)
+        int samples = (int)std::ceil(std::max(std::fabs(xa), std::fabs(ya)) / 4.0f);
+        if (samples < 1) samples = 1;
+        for (int i = 1; i <= samples; i++) {
+            float sx = x + xa * i / samples;
+            float sy = y + ya * i / samples;
+            ArcStep step;
+            step.x0 = (int8_t)tileOf(sx - Mario::WIDTH);
+            step.x1 = (int8_t)tileOf(sx + Mario::WIDTH);
+            step.y0 = (int8_t)tileOf(sy - bodyHeight);
+            step.y1 = (int8_t)tileOf(sy);
+            step.rising = ya < 0;
+            step.landing = ya > 0 && step.y1 > footRow;
+            footRow = step.y1;
+            if (step == last) continue;
+            last = step;
+            
+            int child = tree[node].firstChild;
+            while (child >= 0 && !(tree[child].step == step)) {
+                child = tree[child].nextSibling;
+            }
+            if (child < 0) {
+                child = (int)tree.size();
+                ArcNode added;
+                added.step = step;
+                added.nextSibling = tree[node].firstChild;
+                tree.push_back(added);
+                tree[node].firstChild = child;
+            }
+            node = child;
+        }
+        x += xa;
+        y += ya;
+        
+        ya *= Mario::VERTICAL_DAMPING;
+        xa *= Mario::AIR_INERTIA;
+        ya += Mario::GRAVITY;
+    }
+}
+
+// Short hops (for low ceilings) are tried at every hold length and
+// higher jumps at every other one, each with a running or walking
+// take-off and with steering in mid-air after jumping straight up
+// (needed to climb walls right next to Mario). The rightward tree also
+// holds the plain vertical jumps.
+static ArcTree buildArcs(int bodyHeight, int dir) {
+    // Top speed is where acceleration and inertia balance
+    const float runSpeed = Mario::RUN_ACCELERATION * Mario::GROUND_INERTIA / (1 - Mario::GROUND_INERTIA);
+    const float walkSpeed = Mario::WALK_ACCELERATION * Mario::GROUND_INERTIA / (1 - Mario::GROUND_INERTIA);
+    
+    ArcTree tree(1);
+    tree[0].step = ArcStep{0, 0, 0, 0, false, false};
+    for (int hold = 1; hold <= Mario::JUMP_TIME + 1; hold += (hold < 4 ? 1 : 2)) {
+        if (dir > 0) addArc(tree, hold, 0, 0, 0, bodyHeight);
+        addArc(tree, hold, dir * runSpeed, dir * Mario::RUN_ACCELERATION, 0, bodyHeight);
+        addArc(tree, hold, dir * walkSpeed, dir * Mario::WALK_ACCELERATION, 0, bodyHeight);
+        for (int steerTick = 0; steerTick <= Mario::JUMP_TIME; steerTick += 3) {
+            addArc(tree, hold, 0, dir * Mario::RUN_ACCELERATION, steerTick, bodyHeight);
+        }
+    }
+    return tree;
+}
+
+struct ArcSet {
+    ArcTree right;
+    ArcTree left;
+    
+    explicit ArcSet(int bodyHeight)
+        : right(buildArcs(bodyHeight, 1)), left(buildArcs(bodyHeight, -1)) {}
+};
+
+static const ArcSet& arcsFor(bool large) {
+    static const ArcSet smallArcs(Mario::SMALL_HEIGHT);
+    static const ArcSet largeArcs(Mario::LARGE_HEIGHT);
+    return large ? largeArcs : smallArcs;
+}
+
+// Bits yLow..yHigh of a column mask (rows above the level are open)
+static uint64_t rowRange(int yLow, int yHigh) {
+    if (yLow < 0) yLow = 0;
+    if (yHigh > 63) yHigh = 63;
+    if (yLow > yHigh) return 0;
+    return (~0ull >> (63 - yHigh)) & (~0ull << yLow);
+}
+
+/// Search state for one level
+struct Search {
+    const Level* level;
+    const ArcSet* arcs;
+    int bodyRows;                ///< 1 for small Mario, 2 for large
+    // One bit per row for each column. Rows below the level repeat the
+    // bottom row, as Level::getBlock does.
+    std::vector<uint64_t> blockAll;     ///< Blocks from every side
+    std::vector<uint64_t> blockRising;  ///< Blocks a head moving up
+    std::vector<uint64_t> solidTops;    ///< Can be stood on (inside the level only)
+    std::vector<uint8_t> seen;   ///< Standing cells, rows -1 .. height-2
+    // Cells still to expand. Cell indices grow with x, so popping the
+    // largest first heads straight for the exit on winnable levels.
+    // Jumps to the left are only tried once that runs dry.
+    std::priority_queue<int> open;
+    std::vector<int> backtrack;
+    std::vector<int> stack;
+    ValidationResult result;
+    
+    void buildMasks() {
+        blockAll.assign(level->width, 0);
+        blockRising.assign(level->width, 0);
+        solidTops.assign(level->width, 0);
+        const uint64_t below = ~0ull << (level->height - 1);
+        for (int x = 0; x < level->width; x++) {
+            const uint8_t* column = &level->map[x * level->height];
+            for (int y = 0; y < level->height; y++) {
+                uint8_t solidity = Level::TILE_TABLES.solidity[column[y]];
+                uint64_t bit = 1ull << y;
+                if (solidity & TileTables::SOLID_SIDEWAYS) blockAll[x] |= bit;
+                if (solidity & TileTables::SOLID_RISING) blockRising[x] |= bit;
+                if (solidity & TileTables::SOLID_FALLING) solidTops[x] |= bit;
+            }
+            if (blockAll[x] & (below & ~(below << 1))) blockAll[x] |= below;
+            if (blockRising[x] & (below & ~(below << 1))) blockRising[x] |= below;
+        }
+    }
+    
+    bool solidTop(int x, int y) const {
+        return y >= 0 && y < 64 && ((solidTops[x] >> y) & 1);
+    }
+    
+    bool bodyFree(int x, int y) const {
+        return (blockAll[x] & rowRange(y - bodyRows + 1, y)) == 0;
+    }
+    
+    void visit(int x, int y) {
+        if (x < 0 || x >= level->width || y < -1 || y > level->height - 2) return;
+        int index = x * level->height + y + 1;
+        if (seen[index]) return;
+        seen[index] = 1;
+        open.push(index);
+        backtrack.push_back(index);
+        result.cellsVisited++;
+        if (x > result.stuckX) {
+            result.stuckX = x;
+            result.stuckY = y;
+        }
+        if (x >= level->xExit) result.reachable = true;
+    }
+    
+    // Fall straight down column x from row y until something holds Mario
+    void drop(int x, int y) {
+        for (int yy = y + 1; yy < level->height; yy++) {
+            if (solidTop(x, yy)) {
+                visit(x, yy - 1);
+                return;
+            }
+        }
+    }
+    
+    void walk(int x, int y) {
+        if (x < 0 || x >= level->width || !bodyFree(x, y)) return;
+        if (x >= level->xExit) result.reachable = true;
+        if (solidTop(x, y + 1)) {
+            visit(x, y);
+        } else {
+            drop(x, y);
+        }
+    }
+    
+    // Follow one step from (cx, cy); false ends this branch of the tree
+    bool follow(const ArcStep& step, int cx, int cy) {
+        int x0 = cx + step.x0;
+        int x1 = cx + step.x1;
+        if (x0 < 0 || x1 >= level->width) return false;
+        if (x1 >= level->xExit) {
+            result.reachable = true;
+            return false;
+        }
+        int feet = cy + step.y1;
+        if (feet > level->height) return false;  // Fell out of the level
+        
+        if (step.landing) {
+            for (int x = x0; x <= x1; x++) {
+                if (solidTop(x, feet) && bodyFree(x, feet - 1)) {
+                    visit(x, feet - 1);
+                    return false;
+                }
+            }
+        }
+        
+        const std::vector<uint64_t>& blocking = step.rising ? blockRising : blockAll;
+        return ((blocking[x0] | blocking[x1]) & rowRange(cy + step.y0, feet)) == 0;
+    }
+    
+    void jump(const ArcTree& tree, int cx, int cy) {
+        stack.clear();
+        stack.push_back(0);
+        while (!stack.empty() && !result.reachable) {
+            int node = stack.back();
+            stack.pop_back();
+            for (int child = tree[node].firstChild; child >= 0; child = tree[child].nextSibling) {
+                if (follow(tree[child].step, cx, cy)) stack.push_back(child);
+            }
+        }
+    }
+};
+
+ValidationResult LevelValidator::validate(const Level* level, bool large) {
+    Search search;
+    if (level->height > MAX_HEIGHT) return search.result;
+    
+    search.level = level;
+    search.arcs = &arcsFor(large);
+    search.bodyRows = large ? 2 : 1;
+    search.seen.assign((size_t)level->width * level->height, 0);
+    search.buildMasks();
+    search.stack.reserve(256);
+    
+    // Mario spawns at (32, 0) and falls to the ground
+    search.drop(2, -1);
+    
+    while (!search.result.reachable) {
+        int index;
+        bool forward = !search.open.empty();
+        if (forward) {
+            index = search.open.top();
+            search.open.pop();
+        } else if (!search.backtrack.empty()) {
+            index = search.backtrack.back();
+            search.backtrack.pop_back();
+        } else {
+            break;
+        }
+        int cx = index / level->height;
+        int cy = index % level->height - 1;
+        
+        if (forward) {
+            search.walk(cx - 1, cy);
+            search.walk(cx + 1, cy);
+            search.jump(search.arcs->right, cx, cy);
+        } else {
+            search.jump(search.arcs->left, cx, cy);
+        }
+    }
+    return search.result;
+}
@@ -11,12 +11,13 @@
 #include <algorithm>
 #include <utility>
 
-MapScene::MapScene(Game* game, long seed) : seed(seed), random(seed) {
+MapScene::MapScene(Game* game, int64_t seed) : seed(seed), random(seed) {
     this->game = game;
 }
 
 void MapScene::init() {
     DEBUG_PRINT("init() starting...");
+    if (!worldMap.held()) worldMap = AssetHandle(ASSET_WORLD_MAP);
     worldNumber = -1;
     nextWorld();
     DEBUG_PRINT("init() complete");
@@ -33,6 +34,7 @@ void MapScene::nextWorld() {
     }
     
     moveTime = 0;
+    xPregen = yPregen = -1;
     levelId = 0;
     farthest = 0;
     xFarthestCap = 0;
@@ -41,7 +43,7 @@ void MapScene::nextWorld() {
     seed = random.nextLong();
     random = Random(seed);
     
-    DEBUG_PRINT("Generating level with seed=%ld", seed);
+    DEBUG_PRINT("Generating level with seed=%lld", (long long)seed);
     
     // Keep generating until we get a valid map (with limit to prevent infinite loop)
     int attempts = 0;
@@ -97,7 +99,7 @@ void MapScene::startMusic() {
 
 bool MapScene::generateLevel() {
     random = Random(seed);
-    DEBUG_PRINT("MapScene::generateLevel() with seed=%ld", (long)seed);
+    DEBUG_PRINT("MapScene::generateLevel() with seed=%lld", (long long)seed);
     
     ImprovedNoise n0(random.nextLong());
     ImprovedNoise n1(random.nextLong());
@@ -416,53 +418,28 @@ void MapScene::tick() {
             if (x >= 0 && x < (int)level.size() && y >= 0 && y < (int)level[0].size()) {
                 DEBUG_PRINT("MapScene: Trying to enter level at (%d,%d) tile=%d data=%d", 
                             x, y, level[x][y], data[x][y]);
-                if (level[x][y] == TILE_LEVEL && data[x][y] != -11) {
-                    if (data[x][y] != 0 && data[x][y] > -10) {
-                        // Build level string (e.g. "1-1", "2-X", "3-?")
-                        Mario::levelString = std::to_string(worldNumber + 1) + "-";
-                        
-                        int difficulty = worldNumber + 1;
-                        int type = 0;  // Overworld (TYPE_OVERGROUND)
-                        
-                        // Use level position to deterministically choose level type
-                        Random levelRng(seed + x * 313211 + y * 534321);
-                        
-                        // Match Java logic exactly:
-                        // - For numbered levels (data > 1), 33% chance of underground
-                        // - For any negative data (caps, castles, bonus), always castle type
-                        if (data[x][y] > 1 && levelRng.nextInt(3) == 0) {
-                            type = 1;  // Underground
-                        }
-                        
-                        if (data[x][y] < 0) {
-                            // All negative values become castle
-                            if (data[x][y] == -2) {
-                                // Final castle
-                                Mario::levelString += "X";
-                                difficulty += 2;
-                            } else if (data[x][y] == -1) {
-                                // Cap level
-                                Mario::levelString += "?";
-                            } else {
-                                // Bonus level (-3)
-                                Mario::levelString += "#";
-                                difficulty += 1;
-                            }
-                            type = 2;  // Castle
-                        } else {
-                            Mario::levelString += std::to_string(data[x][y]);
-                        }
-                        
-                        DEBUG_PRINT("MapScene: Entering level at (%d,%d) type=%d difficulty=%d", x, y, type, difficulty);
-                        Art::stopMusic();
-                        game->startLevel(seed * x * y + x * 31871 + y * 21871, difficulty, type);
-                    } else {
-                        DEBUG_PRINT("MapScene: Cannot enter - data=%d (need !=0 and >-10)", data[x][y]);
-                    }
+                LevelKey key;
+                std::string levelString;
+                if (levelAt(x, y, key, levelString)) {
+                    Mario::levelString = levelString;
+                    DEBUG_PRINT("MapScene: Entering level at (%d,%d) type=%d difficulty=%d",
+                                x, y, key.type, key.difficulty);
+                    Art::stopMusic();
+                    game->startLevel(key.seed, key.difficulty, key.type);
+                    xPregen = yPregen = -1;  // Ask again when we come back
+                } else if (level[x][y] == TILE_LEVEL && data[x][y] != -11) {
+                    DEBUG_PRINT("MapScene: Cannot enter - data=%d (need !=0 and >-10)", data[x][y]);
                 }
             }
         }
         
+        // Standing still: get the levels around here built in the background
+        if (x != xPregen || y != yPregen) {
+            xPregen = x;
+            yPregen = y;
+            requestNearbyLevels(x, y);
+        }
+        
         canEnterLevel = !keys[Mario::KEY_JUMP] && !keys[Mario::KEY_SPEED];
         
         if (keys[Mario::KEY_LEFT]) tryWalking(-1, 0);
@@ -472,6 +449,113 @@ void MapScene::tick() {
     }
 }
 
+/**
+ * Seed for generating the level at map node (x, y).
+ */
+int64_t MapScene::levelSeedAt(int64_t worldSeed, int x, int y) {
+    // seed * x * y + x * 31871 + y * 21871, done unsigned so overflow wraps
+    uint64_t s = (uint64_t)worldSeed * (uint64_t)(int64_t)x * (uint64_t)(int64_t)y +
+                 (uint64_t)(int64_t)x * 31871u + (uint64_t)(int64_t)y * 21871u;
+    return (int64_t)s;
+}
+
+/**
+ * Seed for choosing the type of the level at map node (x, y).
+ */
+int64_t MapScene::levelTypeSeedAt(int64_t worldSeed, int x, int y) {
+    uint64_t s = (uint64_t)worldSeed + (uint64_t)(int64_t)x * 313211u + (uint64_t)(int64_t)y * 534321u;
+    return (int64_t)s;
+}
+
+/**
+ * Works out the level behind the map node at (x, y).
+ * 
+ * @return false if (x, y) is not an enterable level node (roads, completed
+ *         levels and the start tile)
+ */
+bool MapScene::levelAt(int x, int y, LevelKey& key, std::string& levelString) const {
+    if (x < 0 || x >= (int)level.size() || y < 0 || y >= (int)level[0].size()) return false;
+    if (level[x][y] != TILE_LEVEL || data[x][y] == -11) return false;
+    if (data[x][y] == 0 || data[x][y] <= -10) return false;
+    
+    // Build level string (e.g. "1-1", "2-X", "3-?")
+    levelString = std::to_string(worldNumber + 1) + "-";
+    
+    int difficulty = worldNumber + 1;
+    int type = 0;  // Overworld (TYPE_OVERGROUND)
+    
+    // Use level position to deterministically choose level type
+    Random levelRng(levelTypeSeedAt(seed, x, y));
+    
+    // Match Java logic exactly:
+    // - For numbered levels (data > 1), 33% chance of underground
+    // - For any negative data (caps, castles, bonus), always castle type
+    if (data[x][y] > 1 && levelRng.nextInt(3) == 0) {
+        type = 1;  // Underground
+    }
+    
+    if (data[x][y] < 0) {
+        // All negative values become castle
+        if (data[x][y] == -2) {
+            // Final castle
+            levelString += "X";
+            difficulty += 2;
+        } else if (data[x][y] == -1) {
+            // Cap level
+            levelString += "?";
+        } else {
+            // Bonus level (-3)
+            levelString += "#";
+            difficulty += 1;
+        }
+        type = 2;  // Castle
+    } else {
+        levelString += std::to_string(data[x][y]);
+    }
+    
+    key = {levelSeedAt(seed, x, y), difficulty, type};
+    return true;
+}
+
+/**
+ * Queues pregeneration of the level under Mario (if any) and of every
+ * level node reachable from here along roads without passing through
+ * another node.
+ */
+void MapScene::requestNearbyLevels(int x, int y) {
+    if (level.empty()) return;
+    int width = (int)level.size();
+    int height = (int)level[0].size();
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    
+    std::vector<LevelKey> keys;
+    LevelKey key;
+    std::string levelString;
+    if (levelAt(x, y, key, levelString)) keys.push_back(key);
+    
+    std::vector<bool> visited(width * height, false);
+    std::vector<std::pair<int, int>> open{{x, y}};
+    visited[x * height + y] = true;
+    static const int DIRS[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    while (!open.empty()) {
+        auto [cx, cy] = open.back();
+        open.pop_back();
+        for (const auto& d : DIRS) {
+            int nx = cx + d[0];
+            int ny = cy + d[1];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height || visited[nx * height + ny]) continue;
+            visited[nx * height + ny] = true;
+            if (level[nx][ny] == TILE_ROAD) {
+                open.push_back({nx, ny});
+            } else if (level[nx][ny] == TILE_LEVEL && levelAt(nx, ny, key, levelString)) {
+                keys.push_back(key);
+            }
+        }
+    }
+    
+    game->pregenerateLevels(keys);
+}
+
 /**
  * Attempts to move Mario in the specified direction on the world map.
  * 
@@ -3,6 +3,7 @@
  * @brief Player character implementation.
  */
 #include "Mario.h"
+#include "SaveState.h"
 #include "Art.h"
 #include "Scene.h"
 #include "LevelScene.h"
@@ -174,7 +175,7 @@ void Mario::move() {
     visible = ((invulnerableTime / 2) & 1) == 0;
     
     wasOnGround = onGround;
-    float sideWaysSpeed = keys[KEY_SPEED] ? 1.2f : 0.6f;
+    float sideWaysSpeed = keys[KEY_SPEED] ? RUN_ACCELERATION : WALK_ACCELERATION;
     
     if (onGround) {
         ducking = keys[KEY_DOWN] && large;
@@ -191,8 +192,8 @@ void Mario::move() {
         } else if (onGround && mayJump) {
             Art::playSound(SAMPLE_MARIO_JUMP);
             xJumpSpeed = 0;
-            yJumpSpeed = -1.9f;
-            jumpTime = 7;
+            yJumpSpeed = JUMP_SPEED;
+            jumpTime = JUMP_TIME;
             ya = jumpTime * yJumpSpeed;
             onGround = false;
             sliding = false;
@@ -250,10 +251,10 @@ void Mario::move() {
     
     if (sliding) {
         for (int i = 0; i < 1; i++) {
-            world->addSprite(new Sparkle((int)(x + (rand() % 4) - 2) + facing * 8,
-                                          (int)(y + (rand() % 4)) - 24,
-                                          (float)((rand() % 200) / 100.0f - 1),
-                                          (float)(rand() % 100) / 100.0f,
+            world->addSprite(new Sparkle(world, (int)(x + world->random.nextInt(4) - 2) + facing * 8,
+                                          (int)(y + world->random.nextInt(4)) - 24,
+                                          (float)((world->random.nextInt(200)) / 100.0f - 1),
+                                          (float)(world->random.nextInt(100)) / 100.0f,
                                           0, 1, 5));
         }
         ya *= 0.5f;
@@ -267,17 +268,17 @@ void Mario::move() {
         die();
     }
     
-    if (x < 0) {
-        x = 0;
+    if (x < world->level->firstColumn * 16) {
+        x = world->level->firstColumn * 16;
         xa = 0;
     }
     
-    if (x > world->level->width * 16) {
-        x = world->level->width * 16;
+    if (x > world->level->endColumn * 16) {
+        x = world->level->endColumn * 16;
         xa = 0;
     }
     
-    ya *= 0.85f;
+    ya *= VERTICAL_DAMPING;
     if (onGround) {
         xa *= GROUND_INERTIA;
     } else {
@@ -285,7 +286,7 @@ void Mario::move() {
     }
     
     if (!onGround) {
-        ya += 3;
+        ya += GRAVITY;
     }
     
     // Handle carried shell - must sync BOTH current and old positions
@@ -403,8 +404,8 @@ bool Mario::isBlocking(float _x, float _y, float xa, float ya) {
         world->level->setBlock(tx, ty, 0);
         for (int xx = 0; xx < 2; xx++) {
             for (int yy = 0; yy < 2; yy++) {
-                world->addSprite(new Sparkle(tx * 16 + xx * 8 + rand() % 8,
-                                              ty * 16 + yy * 8 + rand() % 8,
+                world->addSprite(new Sparkle(world, tx * 16 + xx * 8 + world->random.nextInt(8),
+                                              ty * 16 + yy * 8 + world->random.nextInt(8),
                                               0, 0, 0, 2, 5));
             }
         }
@@ -600,9 +601,63 @@ void Mario::setKeys(uint8_t mask) {
 
 void Mario::render(SDL_Renderer* renderer, float alpha) {
     if (large) {
-        height = ducking ? 12 : 24;
+        height = ducking ? SMALL_HEIGHT : LARGE_HEIGHT;
     } else {
-        height = 12;
+        height = SMALL_HEIGHT;
     }
     Sprite::render(renderer, alpha);
 }
+
+void Mario::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(facing);
+    out.write<int32_t>(xDeathPos);
+    out.write<int32_t>(yDeathPos);
+    out.write<int32_t>(deathTime);
+    out.write<int32_t>(winTime);
+    out.write(wasOnGround);
+    out.write(onGround);
+    out.write<int32_t>(height);
+    out.write(runTime);
+    out.write(mayJump);
+    out.write(ducking);
+    out.write(sliding);
+    out.write<int32_t>(jumpTime);
+    out.write(xJumpSpeed);
+    out.write(yJumpSpeed);
+    out.write(canShoot);
+    out.write<int32_t>(width);
+    out.write<int32_t>(powerUpTime);
+    out.write<int32_t>(invulnerableTime);
+    out.write(lastLarge);
+    out.write(lastFire);
+    out.write(newLarge);
+    out.write(newFire);
+}
+
+void Mario::readState(StateReader& in) {
+    Sprite::readState(in);
+    facing = in.read<int32_t>();
+    xDeathPos = in.read<int32_t>();
+    yDeathPos = in.read<int32_t>();
+    deathTime = in.read<int32_t>();
+    winTime = in.read<int32_t>();
+    wasOnGround = in.readBool();
+    onGround = in.readBool();
+    height = in.read<int32_t>();
+    runTime = in.read<float>();
+    mayJump = in.readBool();
+    ducking = in.readBool();
+    sliding = in.readBool();
+    jumpTime = in.read<int32_t>();
+    xJumpSpeed = in.read<float>();
+    yJumpSpeed = in.read<float>();
+    canShoot = in.readBool();
+    width = in.read<int32_t>();
+    powerUpTime = in.read<int32_t>();
+    invulnerableTime = in.read<int32_t>();
+    lastLarge = in.readBool();
+    lastFire = in.readBool();
+    newLarge = in.readBool();
+    newFire = in.readBool();
+}
@@ -4,6 +4,7 @@
  */
 // Mushroom.cpp
 #include "Mushroom.h"
+#include "SaveState.h"
 #include "LevelScene.h"
 #include "Level.h"
 #include "Mario.h"
@@ -121,3 +122,21 @@ void Mushroom::bumpCheck(int xTile, int yTile) {
         onGround = false;
     }
 }
+
+void Mushroom::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(facing);
+    out.write<int32_t>(life);
+    out.write(onGround);
+    out.write<int32_t>(width);
+    out.write<int32_t>(height);
+}
+
+void Mushroom::readState(StateReader& in) {
+    Sprite::readState(in);
+    facing = in.read<int32_t>();
+    life = in.read<int32_t>();
+    onGround = in.readBool();
+    width = in.read<int32_t>();
+    height = in.read<int32_t>();
+}
@@ -0,0 +1,197 @@
+/**
+ * @file MusicCache.cpp
+ * @brief Rendering MIDI tracks with FluidSynth on a worker thread.
+ */
+#include "MusicCache.h"
+#include "ResourceArchive.h"
+#include "ResourceIndex.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#ifdef INFINITE_TUX_RENDER_MUSIC
+#include <fluidsynth.h>
+#endif
+
+static const int SAMPLE_RATE = 44100;
+static const int BLOCK_FRAMES = 4096;
+static const uint32_t MAX_FRAMES = SAMPLE_RATE * 60 * 15;  // A track that never ends
+
+struct RenderJob {
+    std::string midi;
+    std::string soundfont;
+    std::string path;
+};
+
+static std::string cacheDirectory;
+
+static std::thread worker;
+static std::mutex mutex;
+static std::condition_variable wakeWorker;
+static std::deque<RenderJob> queue;
+static std::unordered_set<std::string> pending;   ///< Paths queued or rendering
+static std::unordered_set<std::string> rendered;  ///< Paths rendered this run
+static std::unordered_set<std::string> failed;    ///< Not tried again this run
+static std::atomic<bool> stopping(false);
+
+#ifdef INFINITE_TUX_RENDER_MUSIC
+static void putLE(uint8_t* out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// 16-bit stereo PCM header for `frames` frames
+static void wavHeader(uint8_t header[44], uint32_t frames) {
+    uint32_t dataBytes = frames * 4;
+    std::memcpy(header, "RIFF", 4);
+    putLE(header + 4, 36 + dataBytes, 4);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    putLE(header + 16, 16, 4);               // fmt chunk size
+    putLE(header + 20, 1, 2);                // PCM
+    putLE(header + 22, 2, 2);                // Channels
+    putLE(header + 24, SAMPLE_RATE, 4);
+    putLE(header + 28, SAMPLE_RATE * 4, 4);  // Bytes per second
+    putLE(header + 32, 4, 2);                // Bytes per frame
+    putLE(header + 34, 16, 2);               // Bits per sample
+    std::memcpy(header + 36, "data", 4);
+    putLE(header + 40, dataBytes, 4);
+}
+
+// Play the track through a synth of its own as fast as it renders and
+// write the output beside job.path, renamed into place when complete
+static bool render(const RenderJob& job) {
+    fluid_settings_t* settings = new_fluid_settings();
+    fluid_settings_setnum(settings, "synth.sample-rate", SAMPLE_RATE);
+    // Advance the player by rendered samples, not by the wall clock
+    fluid_settings_setstr(settings, "player.timing-source", "sample");
+    fluid_synth_t* synth = new_fluid_synth(settings);
+    fluid_player_t* player = synth ? new_fluid_player(synth) : nullptr;
+    bool ok = player && fluid_synth_sfload(synth, job.soundfont.c_str(), 1) != FLUID_FAILED &&
+              fluid_player_add_mem(player, job.midi.data(), job.midi.size()) == FLUID_OK &&
+              fluid_player_play(player) == FLUID_OK;
+    
+    std::string temp = job.path + ".tmp";
+    FILE* out = ok ? fopen(temp.c_str(), "wb") : nullptr;
+    uint8_t header[44] = {};
+    ok = out && fwrite(header, 1, sizeof(header), out) == sizeof(header);
+    
+    std::vector<int16_t> block(BLOCK_FRAMES * 2);
+    uint32_t frames = 0;
+    while (ok && fluid_player_get_status(player) == FLUID_PLAYER_PLAYING && frames < MAX_FRAMES) {
+        if (stopping) {
+            ok = false;
+            break;
+        }
+        ok = fluid_synth_write_s16(synth, BLOCK_FRAMES, block.data(), 0, 2, block.data(), 1, 2) == FLUID_OK &&
+             fwrite(block.data(), 4, BLOCK_FRAMES, out) == BLOCK_FRAMES;
+        frames += BLOCK_FRAMES;
+    }
+    if (ok) {
+        wavHeader(header, frames);
+        ok = fseek(out, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), out) == sizeof(header);
+    }
+    if (out) ok = fclose(out) == 0 && ok;
+    
+    if (player) delete_fluid_player(player);
+    if (synth) delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+    
+    std::remove(job.path.c_str());
+    if (!ok || std::rename(temp.c_str(), job.path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    DEBUG_PRINT("Rendered %.1f s of music to %s", (double)frames / SAMPLE_RATE, job.path.c_str());
+    return true;
+}
+#endif
+
+static void workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeWorker.wait(lock, [] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        RenderJob job = std::move(queue.front());
+        queue.pop_front();
+        
+        lock.unlock();
+        bool ok = false;
+#ifdef INFINITE_TUX_RENDER_MUSIC
+        ok = render(job);
+#endif
+        lock.lock();
+        pending.erase(job.path);
+        if (ok) {
+            rendered.insert(job.path);
+        } else if (!stopping) {
+            // The MIDI file keeps playing
+            std::cerr << "[AUDIO] Could not render music to " << job.path << std::endl;
+            failed.insert(job.path);
+        }
+    }
+}
+
+bool MusicCache::available() {
+#ifdef INFINITE_TUX_RENDER_MUSIC
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MusicCache::setDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+}
+
+std::string MusicCache::find(const std::string& midi, const std::string& soundfont, int synth) {
+    if (!available() || cacheDirectory.empty() || midi.empty() || soundfont.empty()) return "";
+    
+    std::string key = midi;
+    key += '\0';
+    key += soundfont;
+    key += '\0';
+    key += std::to_string(synth);
+    char name[40];
+    snprintf(name, sizeof(name), "music-%016llx.wav",
+             (unsigned long long)ResourceArchive::hashBytes((const uint8_t*)key.data(), key.size()));
+    std::string path = cacheDirectory + name;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    if (rendered.count(path)) return path;
+    if (pending.count(path) || failed.count(path)) return "";
+    // Rendered by an earlier run
+    if (ResourceIndex::exists(path)) {
+        rendered.insert(path);
+        return path;
+    }
+    
+    pending.insert(path);
+    queue.push_back(RenderJob{midi, soundfont, path});
+    if (!worker.joinable()) {
+        stopping = false;
+        worker = std::thread(workerLoop);
+    }
+    wakeWorker.notify_one();
+    return "";
+}
+
+void MusicCache::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    wakeWorker.notify_one();
+    if (worker.joinable()) worker.join();
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+    rendered.clear();
+    failed.clear();
+}
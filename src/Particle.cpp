@@ -13,16 +13,16 @@
 
 // Particle.cpp
 #include "Particle.h"
+#include "SaveState.h"
 #include "Art.h"
 #include "LevelScene.h"
-#include <cstdlib>
 
 /**
  * Creates a particle with random sprite frame.
  * Convenience constructor that randomly selects between frame 0 and 1.
  */
-Particle::Particle(int x, int y, float xa, float ya)
-    : Particle(x, y, xa, ya, rand() % 2, 0) {
+Particle::Particle(LevelScene* world, int x, int y, float xa, float ya)
+    : Particle(x, y, xa, ya, world->random.nextInt(2), 0) {
 }
 
 /**
@@ -67,3 +67,13 @@ void Particle::move() {
     ya *= 0.95f;  // Air resistance (slight)
     ya += 3;      // Strong gravity - debris falls fast
 }
+
+void Particle::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(life);
+}
+
+void Particle::readState(StateReader& in) {
+    Sprite::readState(in);
+    life = in.read<int32_t>();
+}
@@ -0,0 +1,362 @@
+/**
+ * @file ResourceArchive.cpp
+ * @brief Resource archive reading and writing, and the LZ4 block codec.
+ */
+#include "ResourceArchive.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <numeric>
+
+static_assert(sizeof(ResourceArchive::Header) == 24, "ResourceArchive::Header layout");
+static_assert(sizeof(ResourceArchive::Entry) == 48, "ResourceArchive::Entry layout");
+
+// Largest entry we decompress or write; SDL_RWops sizes are an int
+static const uint64_t MAX_ORIGINAL_SIZE = INT_MAX;
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// LZ4 block format: sequences of a token (literal count in the high
+// nibble, match length - 4 in the low one; 15 means more bytes follow),
+// the literals, and a 2-byte offset back to the match. The last five
+// bytes are always literals, and the last match starts at least twelve
+// bytes before the end.
+static const size_t LZ4_MIN_MATCH = 4;
+static const size_t LZ4_LAST_LITERALS = 5;
+static const size_t LZ4_MATCH_LIMIT = 12;
+static const size_t LZ4_MAX_OFFSET = 65535;
+
+static void lz4Length(std::vector<uint8_t>& out, size_t length) {
+    for (; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back((uint8_t)length);
+}
+
+static void lz4Sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount,
+                        size_t offset, size_t matchLength) {
+    size_t match = matchLength - LZ4_MIN_MATCH;
+    uint8_t token = (uint8_t)(std::min<size_t>(literalCount, 15) << 4);
+    if (matchLength > 0) token |= (uint8_t)std::min<size_t>(match, 15);
+    out.push_back(token);
+    if (literalCount >= 15) lz4Length(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+    if (matchLength == 0) return;  // Last sequence
+    out.push_back((uint8_t)(offset & 0xFF));
+    out.push_back((uint8_t)(offset >> 8));
+    if (match >= 15) lz4Length(out, match - 15);
+}
+
+// Greedy compressor with one hash table entry per 4-byte prefix; fast
+// and close enough to the reference encoder for our files
+static void lz4Compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(size + size / 255 + 16);
+    std::vector<uint32_t> table(1 << 16, UINT32_MAX);
+    size_t anchor = 0;
+    size_t i = 0;
+    if (size > LZ4_MATCH_LIMIT) {
+        const size_t limit = size - LZ4_MATCH_LIMIT;
+        while (i < limit) {
+            uint32_t prefix;
+            std::memcpy(&prefix, src + i, 4);
+            uint32_t slot = (prefix * 2654435761u) >> 16;
+            size_t candidate = table[slot];
+            table[slot] = (uint32_t)i;
+            if (candidate == UINT32_MAX || i - candidate > LZ4_MAX_OFFSET ||
+                std::memcmp(src + candidate, src + i, 4) != 0) {
+                i++;
+                continue;
+            }
+            size_t length = LZ4_MIN_MATCH;
+            const size_t maxLength = size - LZ4_LAST_LITERALS - i;
+            while (length < maxLength && src[candidate + length] == src[i + length]) {
+                length++;
+            }
+            lz4Sequence(out, src + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        }
+    }
+    lz4Sequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+// Decompress exactly `dstSize` bytes; false on malformed input
+static bool lz4Decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize) {
+    size_t in = 0;
+    size_t out = 0;
+    auto readLength = [&](size_t& length) {
+        uint8_t byte;
+        do {
+            if (in >= size) return false;
+            byte = src[in++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+    
+    while (in < size) {
+        uint8_t token = src[in++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals)) return false;
+        if (literals > size - in || literals > dstSize - out) return false;
+        std::memcpy(dst + out, src + in, literals);
+        in += literals;
+        out += literals;
+        if (in == size) break;  // Last sequence has no match
+        
+        if (size - in < 2) return false;
+        size_t offset = src[in] | (src[in + 1] << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(length)) return false;
+        length += LZ4_MIN_MATCH;
+        if (offset == 0 || offset > out || length > dstSize - out) return false;
+        // Byte by byte: the match may overlap what it produces
+        uint8_t* to = dst + out;
+        const uint8_t* from = to - offset;
+        for (size_t k = 0; k < length; k++) {
+            to[k] = from[k];
+        }
+        out += length;
+    }
+    return out == dstSize;
+}
+
+uint64_t ResourceArchive::hashBytes(const uint8_t* bytes, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool ResourceArchive::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        std::cerr << "Could not open resource archive: " << path << std::endl;
+        return false;
+    }
+    
+    Header header;
+    if (file.size() < sizeof(header)) {
+        std::cerr << "Not a resource archive: " << path << std::endl;
+        file.close();
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != MAGIC) {
+        std::cerr << "Not a resource archive: " << path << std::endl;
+        file.close();
+        return false;
+    }
+    if (header.version != VERSION) {
+        std::cerr << "Unsupported resource archive version " << header.version
+                  << " (expected " << VERSION << "): " << path << std::endl;
+        file.close();
+        return false;
+    }
+    if (header.indexOffset % alignof(Entry) != 0 || header.indexOffset > file.size() ||
+        header.entryCount > (file.size() - header.indexOffset) / sizeof(Entry)) {
+        std::cerr << "Resource archive index is damaged: " << path << std::endl;
+        file.close();
+        return false;
+    }
+    
+    index = reinterpret_cast<const Entry*>(file.data() + header.indexOffset);
+    count = header.entryCount;
+    for (size_t i = 0; i < count; i++) {
+        if (!inFile(index[i])) {
+            std::cerr << "Resource archive index is damaged: " << path << std::endl;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ResourceArchive::close() {
+    file.close();
+    index = nullptr;
+    count = 0;
+}
+
+bool ResourceArchive::inFile(const Entry& entry) const {
+    return entry.offset <= file.size() && entry.size <= file.size() - entry.offset &&
+           entry.nameOffset <= file.size() && entry.nameLength <= file.size() - entry.nameOffset &&
+           entry.originalSize <= MAX_ORIGINAL_SIZE &&
+           (entry.method == LZ4 || (entry.method == STORED && entry.size == entry.originalSize));
+}
+
+std::string_view ResourceArchive::name(const Entry& entry) const {
+    return std::string_view(reinterpret_cast<const char*>(file.data() + entry.nameOffset), entry.nameLength);
+}
+
+const ResourceArchive::Entry* ResourceArchive::find(std::string_view wanted) const {
+    const Entry* end = index + count;
+    const Entry* it = std::lower_bound(index, end, wanted, [this](const Entry& entry, std::string_view wanted) {
+        return name(entry) < wanted;
+    });
+    return (it != end && name(*it) == wanted) ? it : nullptr;
+}
+
+bool ResourceArchive::read(const Entry& entry, std::vector<uint8_t>& out) const {
+    const uint8_t* data = file.data() + entry.offset;
+    if (entry.method == STORED) {
+        out.assign(data, data + entry.size);
+        return true;
+    }
+    out.resize(entry.originalSize);
+    return lz4Decompress(data, entry.size, out.data(), out.size());
+}
+
+// SDL_RWops over a buffer it owns (decompressed entries)
+struct OwnedBuffer {
+    std::vector<uint8_t> bytes;
+    size_t position = 0;
+};
+
+static OwnedBuffer* ownedBuffer(SDL_RWops* rw) {
+    return static_cast<OwnedBuffer*>(rw->hidden.unknown.data1);
+}
+
+static Sint64 ownedSize(SDL_RWops* rw) {
+    return (Sint64)ownedBuffer(rw)->bytes.size();
+}
+
+static Sint64 ownedSeek(SDL_RWops* rw, Sint64 offset, int whence) {
+    OwnedBuffer* buffer = ownedBuffer(rw);
+    Sint64 base = whence == RW_SEEK_SET ? 0 : whence == RW_SEEK_CUR ? (Sint64)buffer->position
+                                                                    : (Sint64)buffer->bytes.size();
+    Sint64 target = base + offset;
+    if (target < 0) target = 0;
+    if (target > (Sint64)buffer->bytes.size()) target = (Sint64)buffer->bytes.size();
+    buffer->position = (size_t)target;
+    return target;
+}
+
+static size_t ownedRead(SDL_RWops* rw, void* to, size_t size, size_t count) {
+    OwnedBuffer* buffer = ownedBuffer(rw);
+    if (size == 0) return 0;
+    size_t objects = std::min(count, (buffer->bytes.size() - buffer->position) / size);
+    std::memcpy(to, buffer->bytes.data() + buffer->position, objects * size);
+    buffer->position += objects * size;
+    return objects;
+}
+
+static size_t ownedWrite(SDL_RWops*, const void*, size_t, size_t) {
+    return 0;
+}
+
+static int ownedClose(SDL_RWops* rw) {
+    delete ownedBuffer(rw);
+    SDL_FreeRW(rw);
+    return 0;
+}
+
+SDL_RWops* ResourceArchive::openRW(const Entry& entry) const {
+    if (entry.method == STORED) {
+        return SDL_RWFromConstMem(file.data() + entry.offset, (int)entry.size);
+    }
+    
+    OwnedBuffer* buffer = new OwnedBuffer();
+    SDL_RWops* rw = read(entry, buffer->bytes) ? SDL_AllocRW() : nullptr;
+    if (!rw) {
+        delete buffer;
+        return nullptr;
+    }
+    rw->size = ownedSize;
+    rw->seek = ownedSeek;
+    rw->read = ownedRead;
+    rw->write = ownedWrite;
+    rw->close = ownedClose;
+    rw->type = SDL_RWOPS_UNKNOWN;
+    rw->hidden.unknown.data1 = buffer;
+    return rw;
+}
+
+ResourceArchiveWriter::~ResourceArchiveWriter() {
+    if (out) fclose(out);
+}
+
+bool ResourceArchiveWriter::open(const std::string& path) {
+    if (out) fclose(out);
+    out = fopen(path.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Could not create resource archive: " << path << std::endl;
+        return false;
+    }
+    offset = 0;
+    failed = false;
+    entries.clear();
+    names.clear();
+    
+    ResourceArchive::Header header = {};  // Completed by finish()
+    writeBytes(&header, sizeof(header));
+    return !failed;
+}
+
+void ResourceArchiveWriter::writeBytes(const void* bytes, size_t size) {
+    if (size > 0 && fwrite(bytes, 1, size, out) != size) failed = true;
+    offset += size;
+}
+
+void ResourceArchiveWriter::pad(size_t alignment) {
+    static const uint8_t zeros[8] = {};
+    writeBytes(zeros, alignUp(offset, alignment) - offset);
+}
+
+bool ResourceArchiveWriter::add(const std::string& name, const std::vector<uint8_t>& bytes) {
+    if (!out || bytes.size() > MAX_ORIGINAL_SIZE) return false;
+    
+    std::vector<uint8_t> compressed;
+    lz4Compress(bytes.data(), bytes.size(), compressed);
+    bool useLz4 = compressed.size() < bytes.size() - bytes.size() / 16;
+    const std::vector<uint8_t>& stored = useLz4 ? compressed : bytes;
+    
+    pad(8);
+    ResourceArchive::Entry entry = {};
+    entry.offset = offset;
+    entry.size = stored.size();
+    entry.originalSize = bytes.size();
+    entry.hash = ResourceArchive::hashBytes(bytes.data(), bytes.size());
+    entry.method = useLz4 ? ResourceArchive::LZ4 : ResourceArchive::STORED;
+    writeBytes(stored.data(), stored.size());
+    entries.push_back(entry);
+    names.push_back(name);
+    return !failed;
+}
+
+bool ResourceArchiveWriter::finish() {
+    if (!out) return false;
+    
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i].nameOffset = offset;
+        entries[i].nameLength = (uint32_t)names[i].size();
+        writeBytes(names[i].data(), names[i].size());
+    }
+    
+    std::vector<size_t> order(entries.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return names[a] < names[b]; });
+    std::vector<ResourceArchive::Entry> sorted;
+    for (size_t i = 0; i < order.size(); i++) {
+        if (i > 0 && names[order[i]] == names[order[i - 1]]) {
+            std::cerr << "Resource added twice: " << names[order[i]] << std::endl;
+            failed = true;
+        }
+        sorted.push_back(entries[order[i]]);
+    }
+    
+    pad(8);
+    ResourceArchive::Header header = {ResourceArchive::MAGIC, ResourceArchive::VERSION,
+                                      (uint32_t)sorted.size(), 0, offset};
+    writeBytes(sorted.data(), sorted.size() * sizeof(ResourceArchive::Entry));
+    if (fseek(out, 0, SEEK_SET) != 0) failed = true;
+    writeBytes(&header, sizeof(header));
+    if (fclose(out) != 0) failed = true;
+    out = nullptr;
+    return !failed;
+}
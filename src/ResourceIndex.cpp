@@ -0,0 +1,205 @@
+/**
+ * @file ResourceIndex.cpp
+ * @brief Directory listings for resource lookups.
+ */
+#include "ResourceIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(INFINITE_TUX_WATCH_RESOURCES) && defined(__linux__)
+#include <sys/inotify.h>
+#define RESOURCE_INDEX_INOTIFY 1
+#endif
+
+struct Listing {
+    std::unordered_set<std::string> files;
+    std::vector<std::string> subdirectories;
+};
+
+// Listings by directory, spelled as the paths asked about spell them
+// (so "resources/" and "./resources/" are listed separately)
+static std::unordered_map<std::string, Listing> listings;
+static std::mutex listingsMutex;
+
+#ifdef RESOURCE_INDEX_INOTIFY
+static int watchFd = -1;
+static std::unordered_map<int, std::string> watchedDirs;  // By watch descriptor
+
+static void watchDirectory(const std::string& dir) {
+    int wd = inotify_add_watch(watchFd, dir.c_str(),
+                               IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                               IN_DELETE_SELF | IN_MOVE_SELF);
+    if (wd >= 0) watchedDirs[wd] = dir;
+}
+#endif
+
+// Read the directory from disk. A missing directory lists as empty.
+static Listing listDirectory(const std::string& dir) {
+    Listing listing;
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE hFind = FindFirstFileA((dir.empty() ? std::string("*") : dir + "*").c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            std::string name = findData.cFileName;
+            if (name == "." || name == "..") continue;
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                listing.subdirectories.push_back(name);
+            } else {
+                listing.files.insert(name);
+            }
+        } while (FindNextFileA(hFind, &findData));
+        FindClose(hFind);
+    }
+#else
+    DIR* handle = opendir(dir.empty() ? "." : dir.c_str());
+    if (!handle) return listing;
+    while (struct dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+        bool isDir = entry->d_type == DT_DIR;
+        bool isFile = entry->d_type == DT_REG;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            // Follow links, as opening the path would
+            struct stat info;
+            if (stat((dir + name).c_str(), &info) != 0) continue;
+            isDir = S_ISDIR(info.st_mode);
+            isFile = S_ISREG(info.st_mode);
+        }
+        if (isDir) {
+            listing.subdirectories.push_back(name);
+        } else if (isFile) {
+            listing.files.insert(name);
+        }
+    }
+    closedir(handle);
+#endif
+    return listing;
+}
+
+// Listing for `dir`, reading it on first use. Caller holds the mutex.
+static const Listing& listingFor(const std::string& dir) {
+    auto it = listings.find(dir);
+    if (it != listings.end()) return it->second;
+#ifdef RESOURCE_INDEX_INOTIFY
+    if (watchFd >= 0) watchDirectory(dir);
+#endif
+    return listings.emplace(dir, listDirectory(dir)).first->second;
+}
+
+bool ResourceIndex::exists(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    
+    std::lock_guard<std::mutex> lock(listingsMutex);
+    return listingFor(dir).files.count(name) > 0;
+}
+
+// Call visit(relative directory, listing) for `dir` and every directory
+// below it, skipping hidden ones. Caller holds the mutex.
+template <typename Visit>
+static void walk(const std::string& dir, Visit visit) {
+    std::vector<std::string> pending{""};
+    while (!pending.empty()) {
+        std::string relative = pending.back();
+        pending.pop_back();
+        const Listing& listing = listingFor(dir + relative);
+        visit(relative, listing);
+        for (const std::string& sub : listing.subdirectories) {
+            if (sub[0] != '.') pending.push_back(relative + sub + "/");
+        }
+    }
+}
+
+void ResourceIndex::preload(const std::string& dir) {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(listingsMutex);
+    
+    size_t dirs = 0;
+    size_t files = 0;
+    walk(dir, [&](const std::string&, const Listing& listing) {
+        dirs++;
+        files += listing.files.size();
+    });
+    DEBUG_PRINT("Indexed %zu files in %zu directories under %s in %.2f ms", files, dirs, dir.c_str(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+std::vector<std::string> ResourceIndex::listFiles(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(listingsMutex);
+    std::vector<std::string> paths;
+    walk(dir, [&](const std::string& relative, const Listing& listing) {
+        for (const std::string& file : listing.files) {
+            paths.push_back(relative + file);
+        }
+    });
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+bool ResourceIndex::watch() {
+#ifdef RESOURCE_INDEX_INOTIFY
+    std::lock_guard<std::mutex> lock(listingsMutex);
+    if (watchFd >= 0) return true;
+    watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFd < 0) {
+        DEBUG_PRINT("inotify unavailable; resource listings will not refresh");
+        return false;
+    }
+    for (const auto& entry : listings) {
+        watchDirectory(entry.first);
+    }
+    DEBUG_PRINT("Watching %zu resource directories", watchedDirs.size());
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ResourceIndex::poll() {
+#ifdef RESOURCE_INDEX_INOTIFY
+    if (watchFd < 0) return;
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(watchFd, buffer, sizeof(buffer))) > 0) {
+        std::lock_guard<std::mutex> lock(listingsMutex);
+        for (char* p = buffer; p < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+            
+            auto watched = watchedDirs.find(event->wd);
+            if (watched == watchedDirs.end()) continue;
+            const std::string& dir = watched->second;
+            // The directory is listed again (and watched again, which
+            // returns the same descriptor) on the next lookup
+            listings.erase(dir);
+            if (event->len > 0) listings.erase(dir + event->name + "/");
+            if (event->mask & IN_IGNORED) watchedDirs.erase(watched);
+        }
+    }
+#endif
+}
+
+void ResourceIndex::clear() {
+    std::lock_guard<std::mutex> lock(listingsMutex);
+    listings.clear();
+#ifdef RESOURCE_INDEX_INOTIFY
+    if (watchFd >= 0) {
+        close(watchFd);
+        watchFd = -1;
+    }
+    watchedDirs.clear();
+#endif
+}
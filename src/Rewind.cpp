@@ -0,0 +1,165 @@
+/**
+ * @file Rewind.cpp
+ * @brief Rewind buffer implementation.
+ */
+#include "Rewind.h"
+#include "LevelScene.h"
+#include "SaveState.h"
+
+// Unchanged gaps shorter than this are folded into the surrounding run,
+// since each run costs 8 bytes of header
+static constexpr size_t MIN_GAP = 8;
+
+Rewind::Rewind(int seconds, int keyframeInterval)
+    : maxFrames(seconds * TICKS_PER_SECOND), keyframeInterval(keyframeInterval) {}
+
+void Rewind::clear() {
+    frames.clear();
+    lastDynamic.clear();
+    pendingEdits.clear();
+    lastScene = nullptr;
+    ticksSinceKeyframe = 0;
+}
+
+void Rewind::record(LevelScene* scene) {
+    if (!scene->level) return;
+    if (scene != lastScene) {
+        clear();
+        lastScene = scene;
+    }
+    
+    StateWriter dynamic;
+    dynamic.buffer.reserve(lastDynamic.size() + 256);
+    scene->writeRewindState(dynamic);
+    
+    Frame frame;
+    if (frames.empty() || ++ticksSinceKeyframe >= keyframeInterval) {
+        frame.keyframe = true;
+        frame.fullDynamic = true;
+        frame.dynamicState = dynamic.buffer;
+        ticksSinceKeyframe = 0;
+    } else if (dynamic.buffer.size() != lastDynamic.size()) {
+        // Sprites were added or removed; offsets no longer line up
+        frame.fullDynamic = true;
+        frame.dynamicState = dynamic.buffer;
+    } else {
+        encodeDiff(lastDynamic, dynamic.buffer, frame.dynamicState);
+    }
+    frame.tileEdits.swap(pendingEdits);
+    frames.push_back(std::move(frame));
+    lastDynamic = std::move(dynamic.buffer);
+    
+    // Drop the oldest keyframe together with its deltas
+    if ((int)frames.size() > maxFrames) {
+        do {
+            frames.pop_front();
+        } while (!frames.empty() && !frames.front().keyframe);
+    }
+    
+    pendingEdits.clear();
+    scene->level->editLog = &pendingEdits;
+}
+
+bool Rewind::restore(LevelScene* scene, int ticksBack) {
+    if (frames.empty() || scene != lastScene) return false;
+    
+    int target = (int)frames.size() - 1 - ticksBack;
+    if (target < 0) target = 0;
+    int key = target;
+    while (key > 0 && !frames[key].keyframe) key--;
+    
+    // Rebuild the dynamic state first so a bad diff leaves the scene alone
+    std::vector<uint8_t> dynamic = frames[key].dynamicState;
+    for (int i = key + 1; i <= target; i++) {
+        const Frame& frame = frames[i];
+        if (frame.fullDynamic) {
+            dynamic = frame.dynamicState;
+        } else if (!applyDiff(dynamic, frame.dynamicState)) {
+            return false;
+        }
+    }
+    
+    // Sprites don't depend on the tiles, so load them before touching the
+    // level. If the snapshot turns out to be bad, put the current sprites
+    // back and leave the level as it is.
+    StateWriter current;
+    current.buffer.reserve(lastDynamic.size() + 256);
+    scene->writeRewindState(current);
+    StateReader dynamicIn(dynamic.data(), dynamic.size());
+    if (!scene->readRewindState(dynamicIn)) {
+        StateReader currentIn(current.buffer.data(), current.buffer.size());
+        scene->readRewindState(currentIn);
+        return false;
+    }
+    
+    // Undo level changes newest first, back to the target tick
+    for (auto edit = pendingEdits.rbegin(); edit != pendingEdits.rend(); ++edit) {
+        scene->level->revertEdit(*edit);
+    }
+    for (int i = (int)frames.size() - 1; i > target; i--) {
+        const auto& edits = frames[i].tileEdits;
+        for (auto edit = edits.rbegin(); edit != edits.rend(); ++edit) {
+            scene->level->revertEdit(*edit);
+        }
+    }
+    
+    frames.erase(frames.begin() + target + 1, frames.end());
+    lastDynamic = std::move(dynamic);
+    ticksSinceKeyframe = target - key;
+    pendingEdits.clear();
+    scene->level->editLog = &pendingEdits;
+    return true;
+}
+
+size_t Rewind::memoryUsed() const {
+    size_t total = lastDynamic.capacity();
+    for (const auto& frame : frames) {
+        total += sizeof(Frame) + frame.dynamicState.capacity()
+               + frame.tileEdits.capacity() * sizeof(Level::TileEdit);
+    }
+    return total;
+}
+
+/**
+ * Diff format: a sequence of runs, each u32 offset, u32 length and the
+ * new bytes. Both states must have the same size.
+ */
+void Rewind::encodeDiff(const std::vector<uint8_t>& prev, const std::vector<uint8_t>& cur,
+                        std::vector<uint8_t>& out) {
+    StateWriter diff;
+    size_t size = cur.size();
+    size_t i = 0;
+    while (i < size) {
+        if (prev[i] == cur[i]) {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        size_t end = i + 1;
+        size_t same = 0;
+        for (size_t j = end; j < size && same < MIN_GAP; j++) {
+            if (prev[j] == cur[j]) {
+                same++;
+            } else {
+                same = 0;
+                end = j + 1;
+            }
+        }
+        diff.write<uint32_t>((uint32_t)start);
+        diff.write<uint32_t>((uint32_t)(end - start));
+        diff.writeBytes(cur.data() + start, end - start);
+        i = end;
+    }
+    out = std::move(diff.buffer);
+}
+
+bool Rewind::applyDiff(std::vector<uint8_t>& state, const std::vector<uint8_t>& diff) {
+    StateReader in(diff.data(), diff.size());
+    while (in.remaining() > 0) {
+        uint32_t offset = in.read<uint32_t>();
+        uint32_t length = in.read<uint32_t>();
+        if (!in.good() || offset > state.size() || length > state.size() - offset) return false;
+        if (!in.readBytes(state.data() + offset, length)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file SaveState.cpp
+ * @brief Savestate file I/O.
+ */
+#include "SaveState.h"
+#include "LevelScene.h"
+#include "Art.h"
+#include <cstdio>
+#include <iostream>
+
+bool SaveState::save(const LevelScene* scene, const std::string& path) {
+    StateWriter out;
+    out.buffer.reserve(64 * 1024);
+    out.write<uint32_t>(MAGIC);
+    out.write<uint32_t>(VERSION);
+    out.write<uint32_t>(0);  // Payload size, patched below
+    scene->writeState(out);
+    
+    uint32_t payloadSize = (uint32_t)(out.buffer.size() - 12);
+    std::memcpy(out.buffer.data() + 8, &payloadSize, sizeof(payloadSize));
+    
+    // Write to a temp file and rename, so a crash mid-save never
+    // leaves a truncated savestate behind
+    std::string tmpPath = path + ".tmp";
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        std::cerr << "Could not write savestate: " << tmpPath << std::endl;
+        return false;
+    }
+    bool ok = fwrite(out.buffer.data(), 1, out.buffer.size(), f) == out.buffer.size();
+    ok = (fclose(f) == 0) && ok;
+    if (ok) {
+        std::remove(path.c_str());
+        ok = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        std::cerr << "Could not write savestate: " << path << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    
+    DEBUG_PRINT("Saved state to %s (%u bytes)", path.c_str(), (unsigned)out.buffer.size());
+    return true;
+}
+
+LevelScene* SaveState::load(Game* game, const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "Could not open savestate: " << path << std::endl;
+        return nullptr;
+    }
+    
+    uint32_t header[3] = {0, 0, 0};
+    if (fread(header, sizeof(uint32_t), 3, f) != 3 || header[0] != MAGIC) {
+        std::cerr << "Not a savestate file: " << path << std::endl;
+        fclose(f);
+        return nullptr;
+    }
+    if (header[1] != VERSION) {
+        std::cerr << "Unsupported savestate version " << header[1]
+                  << " (expected " << VERSION << "): " << path << std::endl;
+        fclose(f);
+        return nullptr;
+    }
+    
+    // Check the size against what the file holds before allocating it
+    long start = ftell(f);
+    bool complete = start >= 0 && fseek(f, 0, SEEK_END) == 0;
+    long end = complete ? ftell(f) : -1;
+    complete = end >= start && (uint64_t)(end - start) >= header[2] && fseek(f, start, SEEK_SET) == 0;
+    std::vector<uint8_t> payload(complete ? header[2] : 0);
+    complete = complete && fread(payload.data(), 1, payload.size(), f) == payload.size();
+    fclose(f);
+    if (!complete) {
+        std::cerr << "Truncated savestate: " << path << std::endl;
+        return nullptr;
+    }
+    
+    StateReader in(payload.data(), payload.size());
+    LevelScene* scene = new LevelScene(game, 0, 0, 0);
+    if (!scene->readState(in) || !in.good()) {
+        std::cerr << "Corrupt savestate: " << path << std::endl;
+        delete scene;
+        return nullptr;
+    }
+    
+    DEBUG_PRINT("Loaded state from %s", path.c_str());
+    return scene;
+}
+
+std::string SaveState::quickSavePath() {
+    return Art::userDataDir + "quicksave.sav";
+}
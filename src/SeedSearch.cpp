@@ -0,0 +1,155 @@
+/**
+ * @file SeedSearch.cpp
+ * @brief Seed scanning with early rejection.
+ */
+#include "SeedSearch.h"
+#include "Level.h"
+#include "LevelGenerator.h"
+#include "LevelScene.h"
+#include "LevelStats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+bool SeedCondition::parse(const std::string& text, SeedCondition& out) {
+    size_t opStart = text.find_first_of("<>=!");
+    if (opStart == std::string::npos || opStart == 0) return false;
+    size_t opEnd = text.find_first_not_of("<>=!", opStart);
+    if (opEnd == std::string::npos) return false;
+    
+    out.field = LevelStats::findField(text.substr(0, opStart));
+    if (out.field < 0) return false;
+    
+    std::string op = text.substr(opStart, opEnd - opStart);
+    if (op == "<") out.op = LESS;
+    else if (op == "<=") out.op = LESS_EQUAL;
+    else if (op == "=" || op == "==") out.op = EQUAL;
+    else if (op == "!=") out.op = NOT_EQUAL;
+    else if (op == ">=") out.op = GREATER_EQUAL;
+    else if (op == ">") out.op = GREATER;
+    else return false;
+    
+    const char* number = text.c_str() + opEnd;
+    char* end = nullptr;
+    out.value = strtod(number, &end);
+    return end != number && *end == '\0';
+}
+
+bool SeedCondition::test(double actual) const {
+    switch (op) {
+        case LESS: return actual < value;
+        case LESS_EQUAL: return actual <= value;
+        case EQUAL: return actual == value;
+        case NOT_EQUAL: return actual != value;
+        case GREATER_EQUAL: return actual >= value;
+        case GREATER: return actual > value;
+    }
+    return false;
+}
+
+bool SeedCondition::failsEarly(const LevelStats& partial) const {
+    // Only upper bounds on fields that keep growing can be settled early
+    if (!LevelStats::fieldGrows(field)) return false;
+    double actual = partial.field(field);
+    switch (op) {
+        case LESS: return actual >= value;
+        case LESS_EQUAL:
+        case EQUAL: return actual > value;
+        default: return false;
+    }
+}
+
+void SeedSearch::setConditions(const std::vector<SeedCondition>& conditions) {
+    needsSprites = false;
+    for (const SeedCondition& condition : conditions) {
+        if (LevelStats::fieldNeedsSprites(condition.field)) needsSprites = true;
+    }
+    predicate = [conditions](const LevelStats& stats, bool complete) {
+        for (const SeedCondition& condition : conditions) {
+            if (complete ? !condition.test(stats.field(condition.field)) : condition.failsEarly(stats)) {
+                return false;
+            }
+        }
+        return true;
+    };
+}
+
+bool SeedSearch::matches(int64_t seed, Level* level, LevelStats& stats) const {
+    stats = LevelStats();
+    int built = 0;
+    
+    GenerateOptions options;
+    options.autotile = false;
+    options.spriteTemplates = needsSprites;
+    options.zoneDone = [&](const Level& partial, int x0, int x1) {
+        stats.addColumns(&partial, x0, x1);
+        built = x1;
+        return !predicate || predicate(stats, false);
+    };
+    if (!LevelGenerator::generateInto(level, seed, difficulty, type, options)) return false;
+    
+    // The exit area and ceilings are added after the last zone, so
+    // measure the finished level from scratch
+    stats = LevelStats::measure(level);
+    stats.seed = seed;
+    stats.type = type;
+    stats.difficulty = difficulty;
+    return !predicate || predicate(stats, true);
+}
+
+std::vector<int64_t> SeedSearch::run(int64_t firstSeed, int64_t count, int64_t* scanned) const {
+    static const int64_t BLOCK = 256;  // Seeds claimed by a worker at a time
+    
+    int workers = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    int64_t blocks = count / BLOCK + (count % BLOCK != 0);
+    workers = (int)std::max<int64_t>(1, std::min<int64_t>(workers, blocks));
+    
+    std::atomic<int64_t> nextBlock(0);
+    std::atomic<size_t> found(0);
+    std::mutex resultMutex;
+    std::vector<int64_t> results;
+    
+    // Blocks are claimed in order and always finished, so when the
+    // search stops at maxMatches every seed below the last claimed block
+    // has been examined and the lowest matches are exact
+    auto work = [&]() {
+        Level level(LevelScene::LEVEL_WIDTH, LevelScene::LEVEL_HEIGHT);
+        LevelStats stats;
+        std::vector<int64_t> local;
+        while (maxMatches == 0 || found < maxMatches) {
+            int64_t block = nextBlock++;
+            if (block >= blocks) break;
+            int64_t start = block * BLOCK;
+            int64_t end = std::min<int64_t>(count, start + BLOCK);
+            for (int64_t i = start; i < end; i++) {
+                // Seeds wrap past INT64_MAX like MapScene::levelSeedAt
+                int64_t seed = (int64_t)((uint64_t)firstSeed + (uint64_t)i);
+                if (matches(seed, &level, stats)) {
+                    local.push_back(seed);
+                    found++;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(resultMutex);
+        results.insert(results.end(), local.begin(), local.end());
+    };
+    
+    std::vector<std::thread> pool;
+    for (int t = 1; t < workers; t++) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    
+    // In scan order, which differs from numeric order once seeds wrap
+    std::sort(results.begin(), results.end(), [firstSeed](int64_t a, int64_t b) {
+        return (uint64_t)a - (uint64_t)firstSeed < (uint64_t)b - (uint64_t)firstSeed;
+    });
+    if (maxMatches > 0 && results.size() > maxMatches) results.resize(maxMatches);
+    if (scanned) *scanned = std::min(count, std::min(nextBlock.load(), blocks) * BLOCK);
+    return results;
+}
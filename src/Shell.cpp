@@ -10,6 +10,7 @@
 
 // Shell.cpp
 #include "Shell.h"
+#include "SaveState.h"
 #include "LevelScene.h"
 #include "Level.h"
 #include "Mario.h"
@@ -38,7 +39,7 @@ Shell::Shell(LevelScene* world, float x, float y, int type)
         int tileX = (int)this->x / 16;
         int tileY = (int)this->y / 16;
         
-        if (tileX >= 0 && tileX < world->level->width && 
+        if (tileX >= world->level->firstColumn && tileX < world->level->endColumn && 
             tileY >= 0 && tileY < world->level->height) {
             uint8_t block = world->level->getBlock(tileX, tileY);
             if ((Level::TILE_BEHAVIORS[block] & Level::BIT_BLOCK_ALL) != 0) {
@@ -286,7 +287,7 @@ bool Shell::fireballCollideCheck(Fireball* fireball) {
             
             xa = fireball->facing * 2;
             ya = -5;
-            if (spriteTemplate) spriteTemplate->isDead = true;
+            if (spriteTemplate) world->level->markTemplateDead(spriteTemplate);
             deadTime = 100;
             yFlipPic = true;  // Flip upside down
             return true;
@@ -325,3 +326,29 @@ void Shell::die() {
     deadTime = 100;
     yFlipPic = true;  // Flip upside down
 }
+
+void Shell::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(facing);
+    out.write(carried);
+    out.write<int32_t>(height);
+    out.write<int32_t>(anim);
+    out.write(dead);
+    out.write<int32_t>(type);
+    out.write(onGround);
+    out.write<int32_t>(width);
+    out.write<int32_t>(deadTime);
+}
+
+void Shell::readState(StateReader& in) {
+    Sprite::readState(in);
+    facing = in.read<int32_t>();
+    carried = in.readBool();
+    height = in.read<int32_t>();
+    anim = in.read<int32_t>();
+    dead = in.readBool();
+    type = in.read<int32_t>();
+    onGround = in.readBool();
+    width = in.read<int32_t>();
+    deadTime = in.read<int32_t>();
+}
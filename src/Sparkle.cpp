@@ -13,13 +13,14 @@
 
 // Sparkle.cpp
 #include "Sparkle.h"
+#include "SaveState.h"
 #include "Art.h"
 #include "LevelScene.h"
-#include <cstdlib>
 
 /**
  * Creates a sparkle effect at the specified position.
  * 
+ * @param world Owning scene (supplies the random lifetime)
  * @param x X position in pixels
  * @param y Y position in pixels
  * @param xa X velocity (can be 0 for stationary sparkles)
@@ -28,7 +29,7 @@
  * @param yPic Y row in particle sheet (different sparkle styles)
  * @param timeSpan Base duration modifier - actual life is 10 + random(0, timeSpan)
  */
-Sparkle::Sparkle(int x, int y, float xa, float ya, int xPic, int yPic, int timeSpan)
+Sparkle::Sparkle(LevelScene* world, int x, int y, float xa, float ya, int xPic, int yPic, int timeSpan)
     : xPicStart(xPic) {
     this->x = x;
     this->y = y;
@@ -45,7 +46,7 @@ Sparkle::Sparkle(int x, int y, float xa, float ya, int xPic, int yPic, int timeS
     
     // Randomize lifetime for visual variety
     // Match Java: life = 10 + random(0 to timeSpan-1)
-    life = 10 + rand() % timeSpan;
+    life = 10 + world->random.nextInt(timeSpan);
 }
 
 /**
@@ -78,3 +79,15 @@ void Sparkle::move() {
     x += xa;
     y += ya;
 }
+
+void Sparkle::writeState(StateWriter& out) const {
+    Sprite::writeState(out);
+    out.write<int32_t>(life);
+    out.write<int32_t>(xPicStart);
+}
+
+void Sparkle::readState(StateReader& in) {
+    Sprite::readState(in);
+    life = in.read<int32_t>();
+    xPicStart = in.read<int32_t>();
+}
@@ -4,6 +4,7 @@
  */
 #include "Sprite.h"
 #include "Art.h"
+#include "SaveState.h"
 #include <cmath>
 
 Sprite::Sprite() {}
@@ -82,3 +83,62 @@ void Sprite::bumpCheck(int xTile, int yTile) {}
 bool Sprite::shellCollideCheck(Shell* shell) { return false; }
 void Sprite::release(Mario* mario) {}
 bool Sprite::fireballCollideCheck(Fireball* fireball) { return false; }
+
+// Sheets a sprite may point at, indexed by their savestate id
+static std::vector<std::vector<SDL_Texture*>>* const SHEETS[] = {
+    nullptr,
+    &Art::mario,
+    &Art::smallMario,
+    &Art::fireMario,
+    &Art::enemies,
+    &Art::items,
+    &Art::level,
+    &Art::particles
+};
+static constexpr int SHEET_COUNT = sizeof(SHEETS) / sizeof(SHEETS[0]);
+
+void Sprite::writeState(StateWriter& out) const {
+    uint8_t sheetId = 0;
+    for (int i = 1; i < SHEET_COUNT; i++) {
+        if (SHEETS[i] == sheet) sheetId = (uint8_t)i;
+    }
+    
+    out.write(xOld);
+    out.write(yOld);
+    out.write(x);
+    out.write(y);
+    out.write(xa);
+    out.write(ya);
+    out.write<int32_t>(xPic);
+    out.write<int32_t>(yPic);
+    out.write<int32_t>(wPic);
+    out.write<int32_t>(hPic);
+    out.write<int32_t>(xPicO);
+    out.write<int32_t>(yPicO);
+    out.write(xFlipPic);
+    out.write(yFlipPic);
+    out.write(visible);
+    out.write<int32_t>(layer);
+    out.write(sheetId);
+}
+
+void Sprite::readState(StateReader& in) {
+    xOld = in.read<float>();
+    yOld = in.read<float>();
+    x = in.read<float>();
+    y = in.read<float>();
+    xa = in.read<float>();
+    ya = in.read<float>();
+    xPic = in.read<int32_t>();
+    yPic = in.read<int32_t>();
+    wPic = in.read<int32_t>();
+    hPic = in.read<int32_t>();
+    xPicO = in.read<int32_t>();
+    yPicO = in.read<int32_t>();
+    xFlipPic = in.readBool();
+    yFlipPic = in.readBool();
+    visible = in.readBool();
+    layer = in.read<int32_t>();
+    uint8_t sheetId = in.read<uint8_t>();
+    sheet = (sheetId < SHEET_COUNT) ? SHEETS[sheetId] : nullptr;
+}
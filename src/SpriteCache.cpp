@@ -0,0 +1,238 @@
+/**
+ * @file SpriteCache.cpp
+ * @brief Sprite sheet conversion and the cooked image cache.
+ */
+#include "SpriteCache.h"
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sys/stat.h>
+
+static const uint32_t CACHE_MAGIC = 0x4b435854;  // "TXCK"
+static const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceHash;
+    int32_t width;
+    int32_t height;
+    uint32_t pathLength;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CacheHeader) == 48, "CacheHeader layout");
+
+/// What a cache file must match to stand in for its source image
+struct SourceStamp {
+    uint64_t size = 0;
+    int64_t time = 0;
+    std::function<uint64_t()> hash;  ///< Contents hash, computed when needed
+};
+
+static std::string cacheDirectory;
+
+static bool statSource(const std::string& path, SourceStamp& stamp) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+    stamp.size = (uint64_t)info.st_size;
+    stamp.time = (int64_t)info.st_mtime;
+    return true;
+}
+
+// FNV-1a of the file contents; 0 if it cannot be read
+static uint64_t hashFile(const std::string& path) {
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) return 0;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint8_t buffer[65536];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            hash = (hash ^ buffer[i]) * 0x100000001b3ULL;
+        }
+    }
+    fclose(in);
+    return hash;
+}
+
+// Cache file name for a source path: its file name plus a hash of the
+// full path, so a user override and the original get separate files
+static std::string cachePathFor(const std::string& sourcePath) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : sourcePath) {
+        hash = (hash ^ (uint8_t)c) * 0x100000001b3ULL;
+    }
+    size_t slash = sourcePath.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? sourcePath : sourcePath.substr(slash + 1);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "-%016llx.rgba", (unsigned long long)hash);
+    return cacheDirectory + name + suffix;
+}
+
+static size_t pixelOffset(uint32_t pathLength) {
+    return (sizeof(CacheHeader) + pathLength + 7) / 8 * 8;
+}
+
+static void writeCache(const std::string& sourcePath, const SourceStamp& stamp, const CookedImage& image) {
+    CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, stamp.size, stamp.time, stamp.hash(),
+                          image.width, image.height, (uint32_t)sourcePath.size(), 0};
+    std::vector<uint8_t> head(pixelOffset(header.pathLength), 0);
+    std::memcpy(head.data(), &header, sizeof(header));
+    std::memcpy(head.data() + sizeof(header), sourcePath.data(), sourcePath.size());
+    
+    // Write beside the real name and rename, so a crash never leaves a
+    // half-written cache file behind
+    std::string path = cachePathFor(sourcePath);
+    std::string temp = path + ".tmp";
+    FILE* out = fopen(temp.c_str(), "wb");
+    if (!out) return;
+    size_t bytes = (size_t)image.width * image.height * 4;
+    bool ok = fwrite(head.data(), 1, head.size(), out) == head.size() &&
+              fwrite(image.pixels, 1, bytes, out) == bytes;
+    ok = fclose(out) == 0 && ok;
+    std::remove(path.c_str());
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return;
+    }
+    DEBUG_PRINT("Stored %s in the sprite cache as %s", sourcePath.c_str(), path.c_str());
+}
+
+static bool readCache(const std::string& sourcePath, const SourceStamp& stamp, CookedImage& out) {
+    if (!out.mapped.open(cachePathFor(sourcePath))) return false;
+    
+    CacheHeader header;
+    if (out.mapped.size() < sizeof(header)) return false;
+    std::memcpy(&header, out.mapped.data(), sizeof(header));
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+        header.width <= 0 || header.height <= 0 || header.width > 16384 || header.height > 16384 ||
+        header.pathLength != sourcePath.size() || header.sourceSize != stamp.size) {
+        return false;
+    }
+    size_t offset = pixelOffset(header.pathLength);
+    size_t bytes = (size_t)header.width * header.height * 4;
+    if (out.mapped.size() != offset + bytes ||
+        std::memcmp(out.mapped.data() + sizeof(header), sourcePath.data(), sourcePath.size()) != 0) {
+        return false;
+    }
+    bool touched = header.sourceTime != stamp.time;
+    if (touched && header.sourceHash != stamp.hash()) {
+        return false;
+    }
+    
+    out.width = header.width;
+    out.height = header.height;
+    out.pixels = out.mapped.data() + offset;
+    // Same contents with a new time: store the new time so the next
+    // start does not hash the file again
+    if (touched) writeCache(sourcePath, stamp, out);
+    return true;
+}
+
+void SpriteCache::setDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+}
+
+// Load from the cache, or decode what open() returns and cook it.
+// `cached` says whether `stamp` is valid.
+static bool loadImage(const std::string& sourcePath, bool cached, const SourceStamp& stamp,
+                      const std::function<SDL_RWops*()>& open, CookedImage& out) {
+    if (cached && readCache(sourcePath, stamp, out)) {
+        DEBUG_PRINT("Loaded %s from the sprite cache", sourcePath.c_str());
+        return true;
+    }
+    out.mapped.close();
+    
+    SDL_RWops* rw = open();
+    SDL_Surface* source = rw ? IMG_Load_RW(rw, 1) : nullptr;
+    if (!source) {
+        std::cerr << "Failed to load image " << sourcePath << ": " << IMG_GetError() << std::endl;
+        return false;
+    }
+    bool cooked = SpriteCache::cook(source, out.storage);
+    out.width = source->w;
+    out.height = source->h;
+    SDL_FreeSurface(source);
+    if (!cooked) {
+        std::cerr << "Failed to convert image " << sourcePath << ": " << SDL_GetError() << std::endl;
+        return false;
+    }
+    out.pixels = out.storage.data();
+    
+    if (cached) writeCache(sourcePath, stamp, out);
+    return true;
+}
+
+bool SpriteCache::load(const std::string& sourcePath, CookedImage& out) {
+    SourceStamp stamp;
+    bool cached = !cacheDirectory.empty() && statSource(sourcePath, stamp);
+    stamp.hash = [&sourcePath]() { return hashFile(sourcePath); };
+    return loadImage(sourcePath, cached, stamp, [&sourcePath]() { return SDL_RWFromFile(sourcePath.c_str(), "rb"); },
+                     out);
+}
+
+bool SpriteCache::load(const std::string& archivePath, const ResourceArchive& archive,
+                       const ResourceArchive::Entry& entry, CookedImage& out) {
+    // The stored hash identifies the contents, so it stands in for the
+    // time: a cache file either matches it or is rebuilt
+    SourceStamp stamp;
+    stamp.size = entry.originalSize;
+    stamp.time = (int64_t)entry.hash;
+    stamp.hash = [&entry]() { return entry.hash; };
+    std::string sourcePath = archivePath + "/" + std::string(archive.name(entry));
+    return loadImage(sourcePath, !cacheDirectory.empty(), stamp, [&]() { return archive.openRW(entry); }, out);
+}
+
+bool SpriteCache::load(const std::string& name, const uint8_t* data, size_t size, CookedImage& out) {
+    return loadImage(name, false, SourceStamp(), [&]() { return SDL_RWFromConstMem(data, (int)size); }, out);
+}
+
+bool SpriteCache::cook(SDL_Surface* source, std::vector<uint8_t>& pixels) {
+    const int width = source->w;
+    const int height = source->h;
+    pixels.assign((size_t)width * height * 4, 0);
+    
+    Uint32 colorKey;
+    bool hasColorKey = SDL_GetColorKey(source, &colorKey) == 0;
+    
+    if (source->format->BytesPerPixel == 1 && source->format->palette) {
+        // Paletted: look each index up once
+        uint8_t palette[256][4];
+        for (int i = 0; i < 256; i++) {
+            SDL_GetRGB((Uint32)i, source->format, &palette[i][0], &palette[i][1], &palette[i][2]);
+            palette[i][3] = (hasColorKey && i == (int)(colorKey & 0xFF)) ? 0 : 255;
+        }
+        SDL_LockSurface(source);
+        for (int y = 0; y < height; y++) {
+            const uint8_t* row = (const uint8_t*)source->pixels + y * source->pitch;
+            uint8_t* dst = &pixels[(size_t)y * width * 4];
+            for (int x = 0; x < width; x++) {
+                std::memcpy(dst + x * 4, palette[row[x]], 4);
+            }
+        }
+        SDL_UnlockSurface(source);
+        return true;
+    }
+    
+    // Everything else converts in one blit. Without an alpha channel the
+    // result is opaque and magenta marks the transparent pixels.
+    bool hasAlpha = source->format->Amask != 0;
+    SDL_Surface* rgba = SDL_CreateRGBSurfaceWithFormatFrom(pixels.data(), width, height, 32, width * 4,
+                                                           SDL_PIXELFORMAT_RGBA32);
+    if (!rgba) return false;
+    if (!hasAlpha) SDL_SetColorKey(source, SDL_FALSE, 0);
+    SDL_SetSurfaceBlendMode(source, SDL_BLENDMODE_NONE);
+    bool ok = SDL_BlitSurface(source, nullptr, rgba, nullptr) == 0;
+    SDL_FreeSurface(rgba);
+    if (!ok) return false;
+    
+    if (!hasAlpha) {
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            pixels[i + 3] = (pixels[i] == 255 && pixels[i + 1] == 0 && pixels[i + 2] == 255) ? 0 : 255;
+        }
+    }
+    return true;
+}
@@ -29,6 +29,7 @@ TitleScene::~TitleScene() {
 
 void TitleScene::init() {
     Art::startMusic(MUSIC_TITLE);
+    Art::preloadMusic(MUSIC_MAP);  // The map comes next
     tickCount = 0;
     wasDown = true;  // Prevent immediate trigger if key held
     selectedOption = 0;
@@ -5,10 +5,13 @@
  */
 
 #include "Game.h"
+#include "LevelGenerator.h"
 #include "Common.h"
 #include <iostream>
+#include <cstdlib>
 #include <cstring>
 #include <cstdio>
+#include <ctime>
 
 // Global debug flag
 bool g_debugMode = false;
@@ -30,6 +33,47 @@ void printHelp(const char* programName) {
     std::cout << "  -t, --test      Enable test mode (see TEST MODE below)\n";
     std::cout << "  --default       Use default input bindings, ignoring config file\n";
     std::cout << "                  (Use this if custom bindings are broken)\n";
+    std::cout << "  --load-state FILE\n";
+    std::cout << "                  Resume a level from a savestate file\n";
+    std::cout << "  --endless [SEED [DIFFICULTY [TYPE]]]\n";
+    std::cout << "                  Play a level with no end, built as you run (TYPE is\n";
+    std::cout << "                  overground, underground, castle or 0-2)\n";
+    std::cout << "  --level-width N Generate levels N tiles wide (64-1000000, default 320);\n";
+    std::cout << "                  the time limit grows with the width\n";
+    std::cout << "  --level-pack FILE\n";
+    std::cout << "                  Load levels from a level pack instead of generating\n";
+    std::cout << "                  them, where the pack has them\n";
+    std::cout << "  --zones FILE    Read zone odds from FILE instead of zones.cfg (must come\n";
+    std::cout << "                  before tool options such as --stats)\n";
+    std::cout << "  --validate SEED COUNT DIFFICULTY\n";
+    std::cout << "                  Check that COUNT levels of each type starting at SEED\n";
+    std::cout << "                  can be finished, list the ones that cannot, and exit\n";
+    std::cout << "  --stats SEED COUNT DIFFICULTY\n";
+    std::cout << "                  Write gap, enemy, block and floor statistics for the\n";
+    std::cout << "                  same levels to stdout as CSV (uses every core) and exit\n";
+    std::cout << "  --find-seeds SEED COUNT DIFFICULTY TYPE CONDITION...\n";
+    std::cout << "                  Scan COUNT seeds for levels of TYPE (overground,\n";
+    std::cout << "                  underground, castle or 0-2) where every CONDITION on a\n";
+    std::cout << "                  --stats column holds, e.g. 'cannons>6' 'gap_max_width<=4',\n";
+    std::cout << "                  write the matches as CSV and exit\n";
+    std::cout << "  --check-hashes [FILE]\n";
+    std::cout << "                  Regenerate the levels listed in the golden hash corpus\n";
+    std::cout << "                  (resources/level-hashes.txt) and report any that differ\n";
+    std::cout << "  --level-hashes  Print a fresh golden hash corpus to stdout and exit\n";
+    std::cout << "  --write-pack FILE SEED COUNT DIFFICULTY [WIDTH]\n";
+    std::cout << "                  Generate COUNT levels of each type starting at SEED\n";
+    std::cout << "                  (WIDTH tiles wide, default 320) into a level pack\n";
+    std::cout << "  --check-pack FILE\n";
+    std::cout << "                  Compare every level in a pack with a freshly generated\n";
+    std::cout << "                  one and report any that differ\n";
+    std::cout << "  --write-archive FILE [DIR]\n";
+    std::cout << "                  Pack the images, sounds and music in DIR (default: the\n";
+    std::cout << "                  resources directory) into a resource archive\n";
+    std::cout << "  --check-archive FILE\n";
+    std::cout << "                  List a resource archive and verify every file in it\n";
+    std::cout << "  --bench-ticks [TICKS]\n";
+    std::cout << "                  Time TICKS level ticks (default 1000) and rewind\n";
+    std::cout << "                  recording on levels 320 to 100000 tiles wide and exit\n";
     std::cout << "\n";
     std::cout << "GAMEPLAY CONTROLS:\n";
     std::cout << "  Arrow Keys      Move left/right, climb vines, duck (down)\n";
@@ -38,6 +82,8 @@ void printHelp(const char* programName) {
     std::cout << "                  pick up shells (hold while stomping)\n";
     std::cout << "  Enter           Pause/unpause game\n";
     std::cout << "  Escape          Quit game\n";
+    std::cout << "  F2 / F3         Quicksave / quickload the current level\n";
+    std::cout << "  F4 (hold)       Rewind the last 10 seconds of the level\n";
     std::cout << "  F9              Cycle MIDI synth (Default/Native/FluidSynth)\n";
     std::cout << "  F10             Cycle scale quality (Nearest/Linear/Best)\n";
     std::cout << "  F11             Toggle fullscreen\n";
@@ -71,8 +117,33 @@ void printHelp(const char* programName) {
     std::cout << "\n";
 }
 
+// Level type from a name (overground, underground, castle) or number
+static int parseLevelType(const char* text) {
+    static const char* typeNames[] = {"overground", "underground", "castle"};
+    for (int t = 0; t < 3; t++) {
+        if (strcmp(text, typeNames[t]) == 0) return t;
+    }
+    return atoi(text);
+}
+
+// An optional argument rather than the next option: anything not starting
+// with '-', or a whole number such as a negative seed
+static bool isOptionalArg(const char* text) {
+    if (text[0] != '-') return true;
+    char* end = nullptr;
+    strtoll(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
 int main(int argc, char* argv[]) {
     bool useDefaultBindings = false;
+    const char* loadStatePath = nullptr;
+    bool endless = false;
+    int64_t endlessSeed = (int64_t)time(nullptr);
+    int endlessDifficulty = 1;
+    int endlessType = 0;
+    int levelWidth = 0;
+    const char* levelPackPath = nullptr;
     
     // Parse command line arguments first to set debug mode early
     for (int i = 1; i < argc; i++) {
@@ -91,6 +162,66 @@ int main(int argc, char* argv[]) {
         if (strcmp(argv[i], "--default") == 0) {
             useDefaultBindings = true;
         }
+        if (strcmp(argv[i], "--load-state") == 0 && i + 1 < argc) {
+            loadStatePath = argv[++i];
+        }
+        if (strcmp(argv[i], "--endless") == 0) {
+            endless = true;
+            if (i + 1 < argc && isOptionalArg(argv[i + 1])) endlessSeed = atoll(argv[++i]);
+            if (i + 1 < argc && isOptionalArg(argv[i + 1])) endlessDifficulty = atoi(argv[++i]);
+            if (i + 1 < argc && isOptionalArg(argv[i + 1])) endlessType = parseLevelType(argv[++i]);
+        }
+        if (strcmp(argv[i], "--level-width") == 0 && i + 1 < argc) {
+            levelWidth = atoi(argv[++i]);
+            if (levelWidth < 64 || levelWidth > 1000000) {
+                std::cerr << "Level width must be between 64 and 1000000 tiles" << std::endl;
+                return 1;
+            }
+        }
+        if (strcmp(argv[i], "--level-pack") == 0 && i + 1 < argc) {
+            levelPackPath = argv[++i];
+        }
+        if (strcmp(argv[i], "--zones") == 0 && i + 1 < argc) {
+            if (!LevelGenerator::loadZoneConfig(argv[++i])) return 1;
+        }
+        if (strcmp(argv[i], "--validate") == 0 && i + 3 < argc) {
+            return Game::validateLevels(atoll(argv[i + 1]), atoll(argv[i + 2]), atoi(argv[i + 3]));
+        }
+        if (strcmp(argv[i], "--stats") == 0 && i + 3 < argc) {
+            return Game::writeLevelStats(atoll(argv[i + 1]), atoll(argv[i + 2]), atoi(argv[i + 3]));
+        }
+        if (strcmp(argv[i], "--level-hashes") == 0) {
+            return Game::writeLevelHashes();
+        }
+        if (strcmp(argv[i], "--check-hashes") == 0) {
+            return Game::checkLevelHashes(i + 1 < argc && argv[i + 1][0] != '-' ? argv[i + 1] : "");
+        }
+        if (strcmp(argv[i], "--write-pack") == 0 && i + 4 < argc) {
+            int width = i + 5 < argc && argv[i + 5][0] != '-' ? atoi(argv[i + 5]) : 0;
+            if (width != 0 && (width < 64 || width > 1000000)) {
+                std::cerr << "Level width must be between 64 and 1000000 tiles" << std::endl;
+                return 1;
+            }
+            return Game::writeLevelPack(argv[i + 1], atoll(argv[i + 2]), atoi(argv[i + 3]), atoi(argv[i + 4]), width);
+        }
+        if (strcmp(argv[i], "--check-pack") == 0 && i + 1 < argc) {
+            return Game::checkLevelPack(argv[i + 1]);
+        }
+        if (strcmp(argv[i], "--write-archive") == 0 && i + 1 < argc) {
+            return Game::writeResourceArchive(argv[i + 1], i + 2 < argc && argv[i + 2][0] != '-' ? argv[i + 2] : "");
+        }
+        if (strcmp(argv[i], "--check-archive") == 0 && i + 1 < argc) {
+            return Game::checkResourceArchive(argv[i + 1]);
+        }
+        if (strcmp(argv[i], "--bench-ticks") == 0) {
+            int ticks = i + 1 < argc && argv[i + 1][0] != '-' ? atoi(argv[i + 1]) : 1000;
+            return Game::benchmarkTicks(ticks > 0 ? ticks : 1000);
+        }
+        if (strcmp(argv[i], "--find-seeds") == 0 && i + 4 < argc) {
+            std::vector<std::string> conditions(argv + i + 5, argv + argc);
+            return Game::findSeeds(atoll(argv[i + 1]), atoll(argv[i + 2]), atoi(argv[i + 3]),
+                                   parseLevelType(argv[i + 4]), conditions);
+        }
     }
     
     // Now output debug info if enabled
@@ -119,6 +250,10 @@ int main(int argc, char* argv[]) {
     
     DEBUG_PRINT("Creating Game object...");
     Game game;
+    if (levelWidth > 0) game.setLevelWidth(levelWidth);
+    if (levelPackPath && !game.useLevelPack(levelPackPath)) {
+        return 1;
+    }
     
     DEBUG_PRINT("Calling game.init()...");
     if (!game.init(useDefaultBindings)) {
@@ -126,6 +261,12 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (loadStatePath) {
+        game.loadState(loadStatePath);
+    } else if (endless) {
+        game.startEndless(endlessSeed, endlessDifficulty, endlessType);
+    }
+    
     DEBUG_PRINT("Calling game.run()...");
     game.run();
     